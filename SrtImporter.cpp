@@ -1,21 +1,25 @@
 #include <windows.h>
 #include <commdlg.h>
+#include <shlobj.h>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <sstream>
+#include <algorithm>
 #include <fstream>
-#include <cmath>
 #include <cstdio>
-#include <cctype>
 #include <memory>
 #include <utility>
-#include <sstream>
+#include <atomic>
+#include <thread>
+#include <map>
+#include <filesystem>
+#include <cwchar>
+#include <cwctype>
 
-#include "plugin2.h"
-#include "logger2.h"
+#include "srt_import.h"
 
 // SRTインポート + 設定UI付き実装
-// 前提: UTF-8対応。改行コードは CRLF/CR/LF に対応。時間→フレームは切り捨て。
+// 前提: UTF-8 / UTF-16 / Shift_JIS 対応 (自動判定)。改行コードは CRLF/CR/LF に対応。時間→フレームは切り捨て。
 
 static HOST_APP_TABLE* g_host = nullptr;
 static EDIT_HANDLE* g_edit = nullptr;
@@ -31,6 +35,30 @@ struct UiControls {
     HWND editColor{};
     HWND editOutline{};
     HWND checkOutline{};
+    HWND editBatch{};
+    HWND comboNewline{};
+    HWND checkTrace{};
+    HWND checkCache{};
+    HWND checkUpdate{};
+    HWND editRangeBegin{};
+    HWND editRangeEnd{};
+    HWND checkRebase{};
+    HWND checkPack{};
+    HWND editMaxLayers{};
+    HWND checkMergeSame{};
+    HWND editMinFrames{};
+    HWND comboShort{};
+    HWND editOffset{};
+    HWND editStretch{};
+    HWND checkSync{};
+    HWND editSyncCueA{};
+    HWND editSyncTimeA{};
+    HWND editSyncCueB{};
+    HWND editSyncTimeB{};
+    HWND buttonImport{};
+    HWND buttonFolder{};
+    HWND buttonCancel{};
+    HWND labelProgress{};
 };
 static UiControls g_ui{};
 
@@ -43,28 +71,42 @@ struct Settings {
     std::string color = "ffffff";
     std::string outline = "000000";
     bool outline_enabled = true;
-};
-
-struct SrtEntry {
-    int start_frame{};
-    int end_frame{};
-    std::string text_utf8;
+    int batch_size = 0; // 1回の編集セクションで反映する件数 (0 以下は一括)
+    NewlineMode newline_mode = NewlineMode::Auto;
+    bool write_trace = false;
+    bool use_cache = true;
+    bool update = false;
+    int64_t range_begin_ms = -1; // 読み込む時刻範囲 (-1 は指定なし)
+    int64_t range_end_ms = -1;
+    bool rebase = false;
+    bool pack_layers = false; // 重なる字幕を別レイヤーに振り分ける
+    int max_layers = 8;
+    bool merge_identical = false; // 同じ本文の連続する字幕を結合する
+    int min_frames = 0;           // これより短い字幕を short_mode で扱う
+    ShortCueMode short_mode = ShortCueMode::Keep;
+    int64_t offset_ms = 0; // 時刻をずらす量
+    double stretch = 1.0;  // 時刻の伸縮 (ずらす前に掛ける)
+    bool sync = false;     // 2点同期 (有効なら offset_ms / stretch の代わりに使う)
+    int sync_cue[2] = { 1, 2 };         // 1始まりのキューの番号 (範囲を指定した場合は範囲内で数える)
+    int64_t sync_ms[2] = { -1, -1 };    // 合わせる時刻 (-1 は指定なし)
 };
 
 // 前方宣言
 static void on_import_menu(EDIT_SECTION* edit);
 static void on_config_menu(HWND hwnd, HINSTANCE dll_hinst);
+static void on_project_load(PROJECT_FILE* project);
 static void register_window_client();
-static std::vector<SrtEntry> parse_srt(const std::wstring& path, int rate, int scale);
 static Settings read_settings_from_ui();
-static void apply_entries_to_timeline(const std::vector<SrtEntry>& entries, const Settings& cfg, EDIT_SECTION* edit);
-static std::string build_alias(const SrtEntry& e, const Settings& cfg);
+static AliasStyle alias_style_from_settings(const Settings& cfg);
+static ImportOptions import_options_from_settings(const Settings& cfg);
+static void join_import_worker();
 
 //---------------------------------------------------------------------
 // ログ出力機能初期化 (任意)
 //---------------------------------------------------------------------
 EXTERN_C __declspec(dllexport) void InitializeLogger(LOG_HANDLE* logger) {
     g_logger = logger;
+    set_import_logger(logger);
 }
 
 //---------------------------------------------------------------------
@@ -79,6 +121,7 @@ EXTERN_C __declspec(dllexport) bool InitializePlugin(DWORD version) {
 // プラグインDLL解放 (任意)
 //---------------------------------------------------------------------
 EXTERN_C __declspec(dllexport) void UninitializePlugin() {
+    join_import_worker();
 }
 
 //---------------------------------------------------------------------
@@ -99,183 +142,352 @@ EXTERN_C __declspec(dllexport) void RegisterPlugin(HOST_APP_TABLE* host) {
     // 設定メニュー (設定→SRT Importer ExMultiLine)
     g_host->register_config_menu(L"SRT Importer ExMultiLine Settings", on_config_menu);
 
+    // プロジェクトが替わったら前回のインポートの記録を捨てる
+    g_host->register_project_load_handler(on_project_load);
+
     // 独自ウィンドウクライアント
     register_window_client();
 }
 
 //---------------------------------------------------------------------
-// SRTパース (UTF-8 + CRLF/CR/LF対応)
+// インポートの進行 (UIスレッド)
 //---------------------------------------------------------------------
-static double parse_time_to_seconds(const std::string& s) {
-    // 00:00:00,000 フォーマット
-    int hh = 0, mm = 0, ss = 0, ms = 0;
-    if (sscanf(s.c_str(), "%d:%d:%d,%d", &hh, &mm, &ss, &ms) != 4) return -1.0;
-    return hh * 3600.0 + mm * 60.0 + ss + ms / 1000.0;
-}
-
-static std::vector<SrtEntry> parse_srt(const std::wstring& path, int rate, int scale) {
-    std::vector<SrtEntry> out;
-
-    // wfstream がパス非対応の環境があるため、_wfopen で読み込む
-    std::string data;
-    {
-        FILE* fp = _wfopen(path.c_str(), L"rb");
-        if (!fp) return out;
-        fseek(fp, 0, SEEK_END);
-        long size = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-        if (size < 0) { fclose(fp); return out; }
-        data.resize((size_t)size);
-        if (size > 0) fread(&data[0], 1, (size_t)size, fp);
-        fclose(fp);
+// ワーカースレッドでの準備完了をウィンドウへ通知する (lparam: std::vector<std::unique_ptr<ImportBatch>>*)
+static constexpr UINT WM_APP_IMPORT_READY = WM_APP + 1;
+// 分割反映の次のバッチを処理する (メッセージループへ一度制御を戻すため自身へ投げる)
+static constexpr UINT WM_APP_IMPORT_STEP = WM_APP + 2;
+
+static std::thread g_import_worker;
+// ワーカーが通知に失敗したときはワーカーから戻すので atomic にしておく
+static std::atomic<bool> g_import_busy = false;
+
+// 分割反映中のインポート。UIスレッドからのみ触る。
+// 複数ファイルは1つのジョブとして順に反映し、各ファイルは前のファイルが使ったレイヤーの次から置く。
+struct ImportJob {
+    std::vector<std::unique_ptr<ImportBatch>> batches;
+    size_t current = 0;                // 反映中のファイル
+    bool started = false;              // batches[current] の反映を始めたか
+    int next_layer = 1;                // 次のファイルを置くレイヤー (1始まり)
+    ImportProgress progress;           // batches[current] の進み具合
+    ImportedLayer* previous = nullptr; // 差分更新の比較対象 (g_imported の要素)
+    size_t inserted = 0;               // 反映し終えたファイルで生成したオブジェクト数
+    size_t files_done = 0;
+    bool cancel = false;
+    bool project_changed = false;      // 反映中にプロジェクトが替わった (ハンドルが無効なので記録を残さない)
+
+    bool done() const { return current >= batches.size(); }
+    ImportBatch& batch() { return *batches[current]; }
+};
+static std::unique_ptr<ImportJob> g_import_job;
+
+// レイヤー (0始まり) ごとの前回のインポート。差分更新で使う。
+static std::map<int, ImportedLayer> g_imported;
+
+static int import_layer_index(const ImportOptions& options) {
+    return std::max(0, options.layer - 1);
+}
+
+static void join_import_worker() {
+    if (g_import_worker.joinable()) g_import_worker.join();
+}
+
+static void set_import_busy(bool busy) {
+    g_import_busy = busy;
+    if (g_ui.buttonImport) EnableWindow(g_ui.buttonImport, busy ? FALSE : TRUE);
+    if (g_ui.buttonFolder) EnableWindow(g_ui.buttonFolder, busy ? FALSE : TRUE);
+    if (g_ui.buttonCancel) EnableWindow(g_ui.buttonCancel, busy ? TRUE : FALSE);
+}
+
+static void update_import_progress(const ImportJob& job) {
+    if (!g_ui.labelProgress) return;
+    std::wstring text = L"進捗: ";
+    if (job.batches.size() > 1) {
+        text += L"[" + std::to_wstring(std::min(job.current + 1, job.batches.size())) + L"/" + std::to_wstring(job.batches.size()) + L"] ";
     }
+    if (!job.done()) text += std::to_wstring(job.progress.next) + L" / " + std::to_wstring(job.batches[job.current]->cues.size());
+    SetWindowTextW(g_ui.labelProgress, text.c_str());
+}
+
+// 計測結果をログへ出し、指定があれば SRT の隣にトレースを書き出す
+static void report_import_metrics(const ImportBatch& batch) {
+    if (g_logger) g_logger->info(g_logger, format_import_metrics(batch.metrics).c_str());
+    if (!batch.options.write_trace) return;
+    const auto trace = import_trace_path(batch.path);
+    const bool ok = write_import_trace(batch.metrics, trace);
+    if (!g_logger) return;
+    if (ok) g_logger->info(g_logger, (L"SRT import trace written: " + trace.wstring()).c_str());
+    else g_logger->warn(g_logger, (L"SRT import trace write failed: " + trace.wstring()).c_str());
+}
 
-    // 簡易UTF-8チェック: BOMがあればスキップ
-    size_t pos = 0;
-    if (data.size() >= 3 && (unsigned char)data[0] == 0xEF && (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF) {
-        pos = 3;
+// batches[current] の反映を始める: 置くレイヤーを決め、差分更新の比較対象を探す
+static void begin_import_file(ImportJob& job) {
+    ImportBatch& batch = job.batch();
+    batch.options.layer = job.next_layer;
+    job.progress = {};
+    job.previous = nullptr;
+    if (batch.options.update) {
+        auto it = g_imported.find(import_layer_index(batch.options));
+        if (it != g_imported.end()) job.previous = &it->second;
     }
-    data = data.substr(pos);
-
-    // 改行コードを LF に正規化 (CRLF / CR / LF すべて許容)
-    std::string normalized;
-    normalized.reserve(data.size());
-    for (size_t idx = 0; idx < data.size(); ++idx) {
-        char c = data[idx];
-        if (c == '\r') {
-            normalized.push_back('\n');
-            if (idx + 1 < data.size() && data[idx + 1] == '\n') {
-                ++idx; // CRLF の LF を読み飛ばす
-            }
-        } else {
-            normalized.push_back(c);
-        }
+    job.started = true;
+}
+
+// batches[current] の反映を終え、ログと差分更新用の記録を残して次のファイルへ進む
+static void finish_import_file(ImportJob& job) {
+    ImportBatch& batch = job.batch();
+    const ImportProgress& progress = job.progress;
+    std::wstring summary = L"SRT import " + std::wstring(job.cancel ? L"cancelled" : L"completed")
+        + L": " + batch.path.filename().wstring() + L" -> layer " + std::to_wstring(batch.options.layer) + L", "
+        + std::to_wstring(progress.inserted) + L" objects from " + std::to_wstring(progress.next) + L" / " + std::to_wstring(batch.cues.size()) + L" cues";
+    if (g_logger) g_logger->info(g_logger, summary.c_str());
+    if (const CoalesceStats& cs = progress.coalesce; cs.saved() && g_logger) {
+        std::wstring detail = L"SRT coalesce: " + std::to_wstring(cs.saved()) + L" objects saved (identical " + std::to_wstring(cs.merged_identical)
+            + L", dropped " + std::to_wstring(cs.dropped) + L", merged short " + std::to_wstring(cs.merged_short) + L")";
+        g_logger->info(g_logger, detail.c_str());
+    }
+    if (job.previous) {
+        const UpdateStats& st = progress.update;
+        std::wstring detail = L"SRT update: kept " + std::to_wstring(st.kept) + L", text " + std::to_wstring(st.retexted)
+            + L", moved " + std::to_wstring(st.moved) + L", recreated " + std::to_wstring(st.recreated)
+            + L", deleted " + std::to_wstring(st.deleted) + L", created " + std::to_wstring(st.created);
+        if (g_logger) g_logger->info(g_logger, detail.c_str());
+    }
+    // 次回の差分更新のために、生成したオブジェクトを記録する。
+    // 差分更新は反映し終えると apply_update 自身が記録を更新するので、途中で中止した場合だけ記録し直す。
+    if (!job.project_changed && (!job.previous || (progress.plan.started() && !progress.plan.done()))) {
+        g_imported[import_layer_index(batch.options)] = record_imported_layer(batch, progress);
+    }
+    report_import_metrics(batch);
+
+    job.inserted += progress.inserted;
+    ++job.files_done;
+    job.next_layer = batch.options.layer + used_layer_count(batch, progress);
+    job.started = false;
+    ++job.current;
+}
+
+static void finish_import_job() {
+    auto job = std::move(g_import_job);
+    set_import_busy(false);
+    if (!job) return;
+
+    // 中止した場合は反映途中のファイルも記録しておく
+    if (!job->done() && job->started) finish_import_file(*job);
+    if (job->batches.size() > 1 && g_logger) {
+        std::wstring summary = L"SRT import: " + std::to_wstring(job->inserted) + L" objects from " + std::to_wstring(job->files_done)
+            + L" / " + std::to_wstring(job->batches.size()) + L" files";
+        g_logger->info(g_logger, summary.c_str());
     }
+    if (job->cancel) {
+        std::wstring msg = L"インポートを中止しました。\n" + std::to_wstring(job->inserted) + L" 件の字幕を挿入済みです。";
+        MessageBox(g_ui.hwnd, msg.c_str(), L"SRT Import", MB_OK | MB_ICONINFORMATION);
+    }
+}
 
-    std::vector<std::string> lines;
-    std::stringstream ss(normalized);
-    std::string line;
-    while (std::getline(ss, line, '\n')) {
-        lines.push_back(line);
+// 1回の編集セクションでの反映。batch_size > 0 なら現在のファイルの次の batch_size 件だけ、
+// そうでなければ残りのファイルをすべて反映する。
+static void apply_import_section(ImportJob& job, EDIT_SECTION* edit) {
+    while (!job.done()) {
+        if (!job.started) begin_import_file(job);
+        ImportBatch& batch = job.batch();
+        if (job.previous) apply_update(batch, *job.previous, job.progress, edit);
+        else apply_import_step(batch, job.progress, edit);
+        const bool file_done = job.progress.next >= batch.cues.size();
+        const bool chunked = batch.options.batch_size > 0;
+        if (file_done) finish_import_file(job);
+        if (chunked) break;
     }
+}
 
-    auto is_blank_line = [](const std::string& s) {
-        for (unsigned char ch : s) {
-            if (!std::isspace(ch)) return false;
-        }
-        return true;
-    };
-
-    size_t i = 0;
-    auto to_frame = [&](double sec) -> int {
-        double f = sec * rate / scale;
-        return (int)std::floor(f); // 切り捨て
-    };
-
-    while (i < lines.size()) {
-        // 先頭の空行をスキップ
-        while (i < lines.size() && is_blank_line(lines[i])) i++;
-        if (i >= lines.size()) break;
-
-        // インデックス行は任意。時刻行でなければ1行だけ読み飛ばして次を時刻行として試す。
-        if (lines[i].find("-->") == std::string::npos) {
-            i++;
-            if (i >= lines.size()) break;
+// 次の編集セクションを実行する。残りがあれば自身へ次のステップを投げる。
+static void run_import_step() {
+    if (!g_import_job) return;
+    auto& job = *g_import_job;
+
+    for (;;) {
+        const size_t before_file = job.current, before_next = job.progress.next;
+        if (!job.cancel && g_edit) {
+            g_edit->call_edit_section_param(&job, [](void* param, EDIT_SECTION* edit) {
+                apply_import_section(*(ImportJob*)param, edit);
+            });
         }
+        update_import_progress(job);
 
-        // 時刻行
-        const auto& tl = lines[i];
-        auto arrow = tl.find("-->");
-        if (arrow == std::string::npos) {
-            while (i < lines.size() && !is_blank_line(lines[i])) i++;
-            continue;
-        }
-        std::string start_str = tl.substr(0, arrow);
-        std::string end_str = tl.substr(arrow + 3);
-        // trim spaces
-        auto trim = [](std::string& s) {
-            while (!s.empty() && isspace((unsigned char)s.front())) s.erase(s.begin());
-            while (!s.empty() && isspace((unsigned char)s.back())) s.pop_back();
-        };
-        trim(start_str);
-        trim(end_str);
-        double start_sec = parse_time_to_seconds(start_str);
-        double end_sec = parse_time_to_seconds(end_str);
-        i++;
-
-        // テキスト行 (複数行字幕に対応)
-        std::string text;
-        while (i < lines.size() && !is_blank_line(lines[i])) {
-            if (!text.empty()) text += '\n';
-            text += lines[i];
-            i++;
+        // 編集セクションが実行されなかった場合も打ち切る
+        if (job.cancel || job.done() || (job.current == before_file && job.progress.next == before_next)) break;
+
+        // メッセージループへ制御を戻してから次のバッチへ進む (中止ボタンや進捗表示を反映するため)。
+        // 通知先のウィンドウが無い場合はこのまま続ける。
+        if (g_ui.hwnd) {
+            if (PostMessageW(g_ui.hwnd, WM_APP_IMPORT_STEP, 0, 0)) return;
+            break;
         }
+    }
+    finish_import_job();
+}
 
-        if (start_sec < 0 || end_sec < 0 || end_sec <= start_sec || text.empty()) {
+// 準備済みのファイルを反映する。読み込めなかったファイルは飛ばす (レイヤーも使わない)。
+static void start_import_job(std::vector<std::unique_ptr<ImportBatch>> batches) {
+    auto job = std::make_unique<ImportJob>();
+    for (auto& batch : batches) {
+        if (batch->cues.empty()) {
+            if (g_logger) g_logger->warn(g_logger, (L"SRT parse failed or empty: " + batch->path.wstring()).c_str());
+            report_import_metrics(*batch);
             continue;
         }
-
-        SrtEntry e;
-        e.start_frame = to_frame(start_sec);
-        e.end_frame = std::max(to_frame(end_sec), e.start_frame + 1);
-        e.text_utf8 = text;
-        out.push_back(std::move(e));
+        if (job->batches.empty()) job->next_layer = batch->options.layer;
+        job->batches.push_back(std::move(batch));
+    }
+    if (job->batches.empty()) {
+        set_import_busy(false);
+        MessageBox(g_ui.hwnd, L"SRTの内容が空か、読み込みに失敗しました。(UTF-8 / UTF-16 / Shift_JIS に対応)", L"SRT Import", MB_OK | MB_ICONWARNING);
+        return;
     }
 
-    return out;
+    g_import_job = std::move(job);
+    set_import_busy(true);
+    update_import_progress(*g_import_job);
+    run_import_step();
+}
+
+static void cancel_import_job() {
+    if (g_import_job) g_import_job->cancel = true;
+}
+
+// プロジェクトを開いた・新規作成した: 記録したハンドルは前のプロジェクトのものなので、差分更新の記録を捨てる。
+// 反映中のインポートは中止し、記録も残さない。
+static void on_project_load(PROJECT_FILE* project) {
+    (void)project;
+    if (g_import_job) {
+        g_import_job->cancel = true;
+        g_import_job->project_changed = true;
+        g_import_job->previous = nullptr;
+    }
+    g_imported.clear();
 }
 
 //---------------------------------------------------------------------
 // インポートメニュー選択時コールバック
 //---------------------------------------------------------------------
-static void handle_import(HWND owner) {
-    wchar_t path[MAX_PATH] = {};
+// 複数選択のファイルダイアログの結果を分解する。
+// 1つだけ選んだ場合は "フルパス\0\0"、複数の場合は "フォルダ\0名前1\0名前2\0...\0\0" になる。
+static std::vector<std::filesystem::path> split_dialog_selection(const wchar_t* buf) {
+    std::vector<std::filesystem::path> out;
+    const std::wstring first = buf;
+    if (first.empty()) return out;
+    const wchar_t* p = buf + first.size() + 1;
+    if (!*p) {
+        out.emplace_back(first);
+        return out;
+    }
+    for (; *p; p += std::wcslen(p) + 1) out.push_back(std::filesystem::path(first) / p);
+    return out;
+}
+
+// SRT ファイルを選ぶ (複数選択可)。キャンセル時は空。
+static std::vector<std::filesystem::path> choose_srt_files(HWND owner) {
+    // 複数選択では名前が連結されるため、MAX_PATH より大きなバッファを使う
+    std::vector<wchar_t> buf(64 * 1024, L'\0');
     OPENFILENAMEW ofn{};
     ofn.lStructSize = sizeof(ofn);
     ofn.hwndOwner = owner;
     ofn.lpstrFilter = L"SRT Files (*.srt)\0*.srt\0All Files (*.*)\0*.*\0";
-    ofn.lpstrFile = path;
-    ofn.nMaxFile = MAX_PATH;
-    ofn.Flags = OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
-    if (!GetOpenFileNameW(&ofn)) return;
-
-    if (!g_edit) return;
-    auto cfg = read_settings_from_ui();
-
-    // プロジェクト操作をまとめて行う
-    g_edit->call_edit_section_param(new std::wstring(path), [](void* param, EDIT_SECTION* edit) {
-        std::unique_ptr<std::wstring> path_ptr((std::wstring*)param);
-        auto entries = parse_srt(*path_ptr, edit->info->rate, edit->info->scale);
-        if (entries.empty()) {
-            if (g_logger) g_logger->warn(g_logger, L"SRT parse failed or empty");
-            MessageBox(edit->info ? nullptr : nullptr, L"SRTの内容が空か、読み込みに失敗しました。(UTF-8のみ対応)", L"SRT Import", MB_OK | MB_ICONWARNING);
-            return;
-        }
-        Settings cfg_local = read_settings_from_ui();
-        apply_entries_to_timeline(entries, cfg_local, edit);
-        if (g_logger) g_logger->info(g_logger, L"SRT import completed");
-    });
+    ofn.lpstrFile = buf.data();
+    ofn.nMaxFile = (DWORD)buf.size();
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_HIDEREADONLY | OFN_EXPLORER | OFN_ALLOWMULTISELECT;
+    if (!GetOpenFileNameW(&ofn)) return {};
+    return split_dialog_selection(buf.data());
+}
+
+// フォルダを選び、直下の .srt を名前順に返す。キャンセル時は空。
+static std::vector<std::filesystem::path> choose_srt_folder(HWND owner) {
+    BROWSEINFOW bi{};
+    bi.hwndOwner = owner;
+    bi.lpszTitle = L"SRTファイルのあるフォルダを選択";
+    bi.ulFlags = BIF_RETURNONLYFSDIRS | BIF_NEWDIALOGSTYLE;
+    // BIF_NEWDIALOGSTYLE は COM の初期化が必要 (ホスト側で初期化済みなら何もしない)
+    const HRESULT com = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    PIDLIST_ABSOLUTE pidl = SHBrowseForFolderW(&bi);
+    wchar_t dir[MAX_PATH] = {};
+    const bool ok = pidl && SHGetPathFromIDListW(pidl, dir) != FALSE;
+    if (pidl) CoTaskMemFree(pidl);
+    if (SUCCEEDED(com)) CoUninitialize();
+    if (!ok) return {};
+
+    std::vector<std::filesystem::path> out;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::wstring ext = it->path().extension().wstring();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+        if (ext == L".srt" && it->is_regular_file(ec)) out.push_back(it->path());
+    }
+    std::sort(out.begin(), out.end());
+    if (out.empty()) MessageBox(owner, L"フォルダに .srt ファイルがありません。", L"SRT Import", MB_OK | MB_ICONINFORMATION);
+    return out;
+}
+
+static void handle_import(HWND owner, bool folder) {
+    if (g_import_busy) return;
+
+    std::vector<std::filesystem::path> paths = folder ? choose_srt_folder(owner) : choose_srt_files(owner);
+    if (paths.empty() || !g_edit) return;
+
+    // 各ファイルは同じ設定で準備し、置くレイヤーは反映時に前のファイルの次から決める
+    const Settings cfg = read_settings_from_ui();
+    auto batches = std::make_unique<std::vector<std::unique_ptr<ImportBatch>>>();
+    for (auto& path : paths) {
+        auto batch = std::make_unique<ImportBatch>();
+        batch->path = std::move(path);
+        batch->options = import_options_from_settings(cfg);
+        batch->style = alias_style_from_settings(cfg);
+        batches->push_back(std::move(batch));
+    }
+
+    // 通知先のウィンドウが無い場合はその場で準備してから反映する
+    HWND notify = g_ui.hwnd;
+    if (!notify) {
+        prepare_import_batches(*batches);
+        start_import_job(std::move(*batches));
+        return;
+    }
+
+    join_import_worker();
+    set_import_busy(true);
+    auto* raw = batches.get();
+    try {
+        g_import_worker = std::thread([notify, raw] {
+            std::unique_ptr<std::vector<std::unique_ptr<ImportBatch>>> b(raw);
+            // ファイルごとに並行して準備する (編集セクションの外)
+            prepare_import_batches(*b);
+            // ウィンドウが既に破棄されていれば通知できないのでここで破棄し、次のインポートを受け付けるようにする
+            if (PostMessageW(notify, WM_APP_IMPORT_READY, 0, (LPARAM)b.get())) b.release();
+            else g_import_busy = false;
+        });
+    } catch (...) {
+        // スレッドを作れない場合はその場で処理する
+        prepare_import_batches(*batches);
+        start_import_job(std::move(*batches));
+        return;
+    }
+    batches.release(); // 所有権はワーカーへ移った
 }
 
 static void on_import_menu(EDIT_SECTION* edit) {
     (void)edit;
-    handle_import(nullptr);
+    handle_import(nullptr, false);
 }
 
 //---------------------------------------------------------------------
 // 設定メニュー (注意書き表示のみ)
 //---------------------------------------------------------------------
 static void on_config_menu(HWND hwnd, HINSTANCE dll_hinst) {
-    MessageBox(hwnd, L"SRT Importer ExMultiLine\n- UTF-8 + 改行CRLF/CR/LF に対応\n- 複数行字幕に対応\n- 時刻→フレームは切り捨て\n- ウィンドウからレイヤー/色/位置を設定してください", L"SRT Importer ExMultiLine", MB_OK | MB_ICONINFORMATION);
+    MessageBox(hwnd, L"SRT Importer ExMultiLine\n- UTF-8 / UTF-16 / Shift_JIS (自動判定) + 改行CRLF/CR/LF に対応\n- 複数行字幕に対応\n- 時刻→フレームは切り捨て\n- ウィンドウからレイヤー/色/位置を設定してください", L"SRT Importer ExMultiLine", MB_OK | MB_ICONINFORMATION);
     (void)dll_hinst;
 }
 
 //---------------------------------------------------------------------
 // テキストオブジェクト生成
 //---------------------------------------------------------------------
-static bool set_item(EDIT_SECTION* edit, OBJECT_HANDLE obj, LPCWSTR effect, LPCWSTR item, const std::string& value) {
-    return edit->set_object_item_value(obj, effect, item, value.c_str());
-}
 static bool set_item_w(EDIT_SECTION* edit, OBJECT_HANDLE obj, LPCWSTR effect, LPCWSTR item, const std::wstring& value) {
     std::string utf8;
     // 簡易UTF-8変換 (Win32のWideCharToMultiByte)
@@ -286,114 +498,6 @@ static bool set_item_w(EDIT_SECTION* edit, OBJECT_HANDLE obj, LPCWSTR effect, LP
     return edit->set_object_item_value(obj, effect, item, utf8.c_str());
 }
 
-// テキスト設定向けに改行を正規化する。
-// - 実改行(CRLF/CR/LF)は LF に統一
-// - エスケープ改行(\n, \N, \r, \r\n) は実改行(LF)に変換
-// - エスケープされたバックスラッシュ(\\)は維持
-static std::string normalize_text_value(const std::string& s) {
-    std::string out;
-    out.reserve(s.size());
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        if (c == '\r') {
-            out.push_back('\n');
-            if (i + 1 < s.size() && s[i + 1] == '\n') ++i;
-            continue;
-        }
-        if (c == '\n') {
-            out.push_back('\n');
-            continue;
-        }
-        if (c == '\\' && i + 1 < s.size()) {
-            char n = s[i + 1];
-            if (n == '\\') {
-                out.push_back('\\');
-                ++i;
-                continue;
-            }
-            if (n == 'n' || n == 'N') {
-                out.push_back('\n');
-                ++i;
-                continue;
-            }
-            if (n == 'r') {
-                out.push_back('\n');
-                ++i;
-                if (i + 2 < s.size() && s[i + 1] == '\\' && (s[i + 2] == 'n' || s[i + 2] == 'N')) {
-                    i += 2; // \r\n 形式をまとめて1改行へ
-                }
-                continue;
-            }
-        }
-        out.push_back(c);
-    }
-    return out;
-}
-
-// API値に含めるため、実改行を \n へエスケープ
-static std::string escape_text_value_newline(const std::string& s) {
-    std::string out;
-    out.reserve(s.size() + 8);
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        if (c == '\\') {
-            out.push_back('\\');
-            out.push_back('\\');
-            continue;
-        }
-        if (c == '\r') {
-            if (i + 1 < s.size() && s[i + 1] == '\n') ++i;
-            out.push_back('\\');
-            out.push_back('n');
-            continue;
-        }
-        if (c == '\n') {
-            out.push_back('\\');
-            out.push_back('n');
-            continue;
-        }
-        out.push_back(c);
-    }
-    return out;
-}
-
-static void apply_entries_to_timeline(const std::vector<SrtEntry>& entries, const Settings& cfg, EDIT_SECTION* edit) {
-    const int target_layer = std::max(0, cfg.layer - 1); // UIは1始まり、APIは0始まり
-    for (const auto& e : entries) {
-        int length = std::max(1, e.end_frame - e.start_frame);
-        auto alias = build_alias(e, cfg);
-        OBJECT_HANDLE obj = edit->create_object_from_alias(alias.c_str(), target_layer, e.start_frame, length);
-        if (!obj) {
-            if (g_logger) g_logger->warn(g_logger, L"create_object_from_alias failed");
-            continue;
-        }
-        std::string text_value = normalize_text_value(e.text_utf8);
-        bool set_ok = set_item(edit, obj, L"テキスト", L"テキスト", text_value);
-        if (!set_ok) {
-            if (g_logger) g_logger->warn(g_logger, L"set_object_item_value(text, raw newline) failed");
-            continue;
-        }
-
-        // 実改行が反映されない環境向けに、必要時のみ \n 形式で再設定を試す
-        if (text_value.find('\n') != std::string::npos) {
-            const char* got = edit->get_object_item_value(obj, L"テキスト", L"テキスト");
-            bool has_multiline_hint = false;
-            if (got) {
-                std::string current(got);
-                has_multiline_hint = (current.find('\n') != std::string::npos)
-                    || (current.find("\\n") != std::string::npos)
-                    || (current.find("\\N") != std::string::npos);
-            }
-            if (!has_multiline_hint) {
-                std::string escaped = escape_text_value_newline(text_value);
-                if (!set_item(edit, obj, L"テキスト", L"テキスト", escaped)) {
-                    if (g_logger) g_logger->warn(g_logger, L"set_object_item_value(text, escaped newline) failed");
-                }
-            }
-        }
-    }
-}
-
 //---------------------------------------------------------------------
 // UIヘルパ
 //---------------------------------------------------------------------
@@ -426,6 +530,29 @@ static std::string narrow_utf8(const std::wstring& ws) {
     WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, out.data(), len, nullptr, nullptr);
     return out;
 }
+static int64_t to_int64(const std::wstring& s, int64_t def) {
+    try {
+        return std::stoll(s);
+    } catch (...) {
+        return def;
+    }
+}
+// "1.0427" のような小数、または "25/23.976" のような比。解釈できない場合は def。
+static double to_ratio(const std::wstring& s, double def) {
+    const size_t slash = s.find(L'/');
+    if (slash == std::wstring::npos) return to_double(s, def);
+    const double num = to_double(s.substr(0, slash), 0.0);
+    const double den = to_double(s.substr(slash + 1), 0.0);
+    return (num > 0 && den > 0) ? num / den : def;
+}
+// "HH:MM:SS,mmm" または "HH:MM:SS" をミリ秒に変換する。空欄・解釈できない場合は -1。
+static int64_t to_time_ms(const std::wstring& s) {
+    const std::string t = narrow_utf8(s);
+    if (t.empty()) return -1;
+    int64_t ms = parse_timestamp_ms(t);
+    if (ms < 0) ms = parse_timestamp_ms(t + ",000");
+    return ms;
+}
 
 static Settings read_settings_from_ui() {
     Settings cfg;
@@ -440,55 +567,82 @@ static Settings read_settings_from_ui() {
     cfg.outline_enabled = g_ui.checkOutline
         ? (SendMessage(g_ui.checkOutline, BM_GETCHECK, 0, 0) == BST_CHECKED)
         : true;
+    cfg.batch_size = to_int(get_window_text(g_ui.editBatch), cfg.batch_size);
+    if (g_ui.comboNewline) {
+        LRESULT sel = SendMessage(g_ui.comboNewline, CB_GETCURSEL, 0, 0);
+        if (sel >= 0 && sel <= (LRESULT)NewlineMode::Verify) cfg.newline_mode = (NewlineMode)sel;
+    }
+    cfg.write_trace = g_ui.checkTrace && SendMessage(g_ui.checkTrace, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    cfg.update = g_ui.checkUpdate && SendMessage(g_ui.checkUpdate, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    cfg.use_cache = g_ui.checkCache
+        ? (SendMessage(g_ui.checkCache, BM_GETCHECK, 0, 0) == BST_CHECKED)
+        : true;
+    if (g_ui.editRangeBegin) cfg.range_begin_ms = to_time_ms(get_window_text(g_ui.editRangeBegin));
+    if (g_ui.editRangeEnd) cfg.range_end_ms = to_time_ms(get_window_text(g_ui.editRangeEnd));
+    cfg.rebase = g_ui.checkRebase && SendMessage(g_ui.checkRebase, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    cfg.pack_layers = g_ui.checkPack && SendMessage(g_ui.checkPack, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    if (g_ui.editMaxLayers) cfg.max_layers = std::max(1, to_int(get_window_text(g_ui.editMaxLayers), cfg.max_layers));
+    cfg.merge_identical = g_ui.checkMergeSame && SendMessage(g_ui.checkMergeSame, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    if (g_ui.editMinFrames) cfg.min_frames = std::max(0, to_int(get_window_text(g_ui.editMinFrames), cfg.min_frames));
+    if (g_ui.comboShort) {
+        LRESULT sel = SendMessage(g_ui.comboShort, CB_GETCURSEL, 0, 0);
+        if (sel >= 0 && sel <= (LRESULT)ShortCueMode::Merge) cfg.short_mode = (ShortCueMode)sel;
+    }
+    if (g_ui.editOffset) cfg.offset_ms = to_int64(get_window_text(g_ui.editOffset), cfg.offset_ms);
+    if (g_ui.editStretch) cfg.stretch = to_ratio(get_window_text(g_ui.editStretch), cfg.stretch);
+    cfg.sync = g_ui.checkSync && SendMessage(g_ui.checkSync, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    if (g_ui.editSyncCueA) cfg.sync_cue[0] = to_int(get_window_text(g_ui.editSyncCueA), cfg.sync_cue[0]);
+    if (g_ui.editSyncCueB) cfg.sync_cue[1] = to_int(get_window_text(g_ui.editSyncCueB), cfg.sync_cue[1]);
+    if (g_ui.editSyncTimeA) cfg.sync_ms[0] = to_time_ms(get_window_text(g_ui.editSyncTimeA));
+    if (g_ui.editSyncTimeB) cfg.sync_ms[1] = to_time_ms(get_window_text(g_ui.editSyncTimeB));
     if (cfg.color.empty()) cfg.color = "ffffff";
     if (cfg.outline.empty()) cfg.outline = "000000";
     return cfg;
 }
 
-//---------------------------------------------------------------------
-// alias生成: テキスト + 標準描画 + 縁取り
-//---------------------------------------------------------------------
-static std::string build_alias(const SrtEntry& e, const Settings& cfg) {
-    (void)e; // テキスト本体は create 後に set_object_item_value で設定する
-    // 数値は少数2桁程度に丸めて文字列化
-    auto num_to_str = [](double v) {
-        char buf[64];
-        std::snprintf(buf, sizeof(buf), "%.2f", v);
-        return std::string(buf);
-    };
-
-    std::ostringstream oss;
-    oss << "[Object]\r\n";
-
-    // Object.0 テキスト (本文/フォント/色/サイズ)
-    oss << "[Object.0]\r\n";
-    oss << "effect.name=テキスト\r\n";
-    oss << "サイズ=" << num_to_str(cfg.size) << "\r\n";
-    oss << "文字色=" << cfg.color << "\r\n";
-    {
-        std::string font_utf8 = narrow_utf8(cfg.font);
-        if (!font_utf8.empty()) {
-            oss << "フォント=" << font_utf8 << "\r\n";
-        }
+static AliasStyle alias_style_from_settings(const Settings& cfg) {
+    AliasStyle style;
+    style.x = cfg.x;
+    style.y = cfg.y;
+    style.size = cfg.size;
+    style.font = narrow_utf8(cfg.font);
+    style.color = cfg.color;
+    style.outline = cfg.outline;
+    style.outline_enabled = cfg.outline_enabled;
+    return style;
+}
+
+static ImportOptions import_options_from_settings(const Settings& cfg) {
+    ImportOptions options;
+    options.layer = cfg.layer;
+    options.batch_size = cfg.batch_size;
+    options.newline_mode = cfg.newline_mode;
+    options.write_trace = cfg.write_trace;
+    options.use_cache = cfg.use_cache;
+    options.update = cfg.update;
+    options.pack_layers = cfg.pack_layers;
+    options.max_layers = cfg.max_layers;
+    options.coalesce.merge_identical = cfg.merge_identical;
+    options.coalesce.min_frames = cfg.min_frames;
+    options.coalesce.short_mode = cfg.short_mode;
+    // 開始・終了のどちらかが指定されていれば範囲読み込みにする
+    if (cfg.range_begin_ms >= 0 || cfg.range_end_ms >= 0) {
+        options.window = true;
+        options.window_begin_ms = std::max<int64_t>(cfg.range_begin_ms, 0);
+        options.window_end_ms = cfg.range_end_ms >= 0 ? cfg.range_end_ms : INT64_MAX;
+        options.rebase = cfg.rebase;
     }
-    // 改行を含む本文は create 後に set_object_item_value で設定する。
-    oss << "テキスト=\r\n";
-
-    // Object.1 標準描画 (位置)
-    oss << "[Object.1]\r\n";
-    oss << "effect.name=標準描画\r\n";
-    oss << "X=" << num_to_str(cfg.x) << "\r\n";
-    oss << "Y=" << num_to_str(cfg.y) << "\r\n";
-
-    // Object.2 縁取り (縁色) ※任意
-    if (cfg.outline_enabled) {
-        oss << "[Object.2]\r\n";
-        oss << "effect.name=縁取り\r\n";
-        oss << "サイズ=3\r\n";
-        oss << "縁色=" << cfg.outline << "\r\n";
+    options.timing.scale = cfg.stretch;
+    options.timing.offset_ms = (double)cfg.offset_ms;
+    // 2点同期は2つのキューと時刻がすべて指定されている場合だけ使う
+    if (cfg.sync && cfg.sync_cue[0] >= 1 && cfg.sync_cue[1] >= 1 && cfg.sync_ms[0] >= 0 && cfg.sync_ms[1] >= 0) {
+        options.sync = true;
+        for (int k = 0; k < 2; ++k) {
+            options.sync_cue[k] = (size_t)(cfg.sync_cue[k] - 1);
+            options.sync_ms[k] = cfg.sync_ms[k];
+        }
     }
-
-    return oss.str();
+    return options;
 }
 
 //---------------------------------------------------------------------
@@ -523,22 +677,112 @@ static LRESULT CALLBACK wnd_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lpar
             x + label_w + 5 + 110, y, 120, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
         SendMessage(g_ui.checkOutline, BM_SETCHECK, BST_CHECKED, 0);
         y += h + gap;
+        CreateWindowExW(0, L"STATIC", L"分割件数", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editBatch = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"0", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | ES_NUMBER, x + label_w + 5, y, 80, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"(0=一括)", WS_CHILD | WS_VISIBLE, x + label_w + 5 + 90, y, 100, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        CreateWindowExW(0, L"STATIC", L"改行方式", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.comboNewline = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | WS_VSCROLL | CBS_DROPDOWNLIST, x + label_w + 5, y, 160, h * 6, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        // NewlineMode の順に並べる
+        for (const wchar_t* item : { L"自動 (初回のみ確認)", L"実改行", L"\\n エスケープ", L"毎回確認 (デバッグ)" }) {
+            SendMessage(g_ui.comboNewline, CB_ADDSTRING, 0, (LPARAM)item);
+        }
+        SendMessage(g_ui.comboNewline, CB_SETCURSEL, 0, 0);
+        y += h + gap;
+        g_ui.checkTrace = CreateWindowExW(0, L"BUTTON", L"計測トレースを出力 (.trace.json)", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        g_ui.checkCache = CreateWindowExW(0, L"BUTTON", L"パース結果をキャッシュする", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        SendMessage(g_ui.checkCache, BM_SETCHECK, BST_CHECKED, 0);
+        y += h + gap;
+        g_ui.checkUpdate = CreateWindowExW(0, L"BUTTON", L"差分更新 (同じレイヤーの前回分と比較)", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 300, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        CreateWindowExW(0, L"STATIC", L"範囲", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editRangeBegin = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 5, y, 95, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"～", WS_CHILD | WS_VISIBLE, x + label_w + 5 + 98, y, 16, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editRangeEnd = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 5 + 116, y, 95, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        g_ui.checkRebase = CreateWindowExW(0, L"BUTTON", L"範囲の開始を0フレームに", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        g_ui.checkPack = CreateWindowExW(0, L"BUTTON", L"重なる字幕を別レイヤーに", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 190, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editMaxLayers = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"8", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | ES_NUMBER, x + 195, y, 40, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"層まで", WS_CHILD | WS_VISIBLE, x + 240, y, 60, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        g_ui.checkMergeSame = CreateWindowExW(0, L"BUTTON", L"同じ本文の連続する字幕を結合", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        CreateWindowExW(0, L"STATIC", L"短い字幕", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editMinFrames = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"0", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | ES_NUMBER, x + label_w + 5, y, 40, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"F未満", WS_CHILD | WS_VISIBLE, x + label_w + 50, y, 40, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.comboShort = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | WS_VSCROLL | CBS_DROPDOWNLIST, x + label_w + 95, y, 110, h * 5, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        // ShortCueMode の順に並べる
+        for (const wchar_t* item : { L"残す", L"削除", L"前に結合" }) {
+            SendMessage(g_ui.comboShort, CB_ADDSTRING, 0, (LPARAM)item);
+        }
+        SendMessage(g_ui.comboShort, CB_SETCURSEL, 0, 0);
+        y += h + gap;
+        CreateWindowExW(0, L"STATIC", L"ずらす(ms)", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editOffset = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"0", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 5, y, 70, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"伸縮", WS_CHILD | WS_VISIBLE, x + label_w + 80, y, 35, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        // 比でも指定できる (25fps 基準の字幕を 23.976fps に合わせるなら 25/23.976)
+        g_ui.editStretch = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 115, y, 95, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        g_ui.checkSync = CreateWindowExW(0, L"BUTTON", L"2点同期", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editSyncCueA = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | ES_NUMBER, x + label_w + 5, y, 45, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"番目→", WS_CHILD | WS_VISIBLE, x + label_w + 53, y, 45, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editSyncTimeA = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 100, y, 110, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
+        // 番号は読み込んだキューの中で数える (範囲を指定した場合は範囲内の1件目が1)
+        CreateWindowExW(0, L"STATIC", L"(範囲内の番号)", WS_CHILD | WS_VISIBLE, x, y, label_w, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editSyncCueB = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"2", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | ES_NUMBER, x + label_w + 5, y, 45, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"番目→", WS_CHILD | WS_VISIBLE, x + label_w + 53, y, 45, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        g_ui.editSyncTimeB = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, x + label_w + 100, y, 110, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        y += h + gap;
 
-        CreateWindowExW(0, L"STATIC", L"※UTF-8 / 改行CRLF・CR・LF対応", WS_CHILD | WS_VISIBLE, x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
+        CreateWindowExW(0, L"STATIC", L"※UTF-8・UTF-16・Shift_JIS / 改行CRLF・CR・LF対応", WS_CHILD | WS_VISIBLE, x, y, 310, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
         y += h + gap;
 
-        CreateWindowExW(0, L"BUTTON", L"Import SRT...", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-            x, y, 180, 28, hwnd, (HMENU)1001, GetModuleHandle(nullptr), nullptr);
+        g_ui.buttonImport = CreateWindowExW(0, L"BUTTON", L"Import SRT...", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+            x, y, 120, 28, hwnd, (HMENU)1001, GetModuleHandle(nullptr), nullptr);
+        g_ui.buttonFolder = CreateWindowExW(0, L"BUTTON", L"フォルダ...", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+            x + 125, y, 90, 28, hwnd, (HMENU)1003, GetModuleHandle(nullptr), nullptr);
+        g_ui.buttonCancel = CreateWindowExW(0, L"BUTTON", L"中止", WS_CHILD | WS_VISIBLE | WS_DISABLED | BS_PUSHBUTTON,
+            x + 220, y, 80, 28, hwnd, (HMENU)1002, GetModuleHandle(nullptr), nullptr);
+        y += 28 + gap;
+        g_ui.labelProgress = CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE, x, y, 260, h, hwnd, nullptr, GetModuleHandle(nullptr), nullptr);
         return 0;
     }
     case WM_COMMAND:
-        if (LOWORD(wparam) == 1001) {
-            handle_import(hwnd);
+        if (LOWORD(wparam) == 1001 || LOWORD(wparam) == 1003) {
+            handle_import(hwnd, LOWORD(wparam) == 1003);
+            return 0;
+        }
+        if (LOWORD(wparam) == 1002) {
+            cancel_import_job();
             return 0;
         }
         break;
+    case WM_APP_IMPORT_READY: {
+        std::unique_ptr<std::vector<std::unique_ptr<ImportBatch>>> batches((std::vector<std::unique_ptr<ImportBatch>>*)lparam);
+        join_import_worker();
+        start_import_job(std::move(*batches));
+        return 0;
+    }
+    case WM_APP_IMPORT_STEP:
+        run_import_step();
+        return 0;
     case WM_DESTROY:
-        if (hwnd == g_ui.hwnd) g_ui = {};
+        if (hwnd == g_ui.hwnd) {
+            cancel_import_job();
+            g_import_job.reset();
+            g_ui = {};
+            set_import_busy(false);
+        }
         break;
     }
     return DefWindowProc(hwnd, msg, wparam, lparam);
@@ -561,7 +805,7 @@ static void register_window_client() {
         kClassName,
         L"SRT Importer ExMultiLine",
         WS_POPUP, // register_window_clientでWS_CHILDが付与される
-        CW_USEDEFAULT, CW_USEDEFAULT, 340, 320,
+        CW_USEDEFAULT, CW_USEDEFAULT, 340, 696,
         nullptr, nullptr, GetModuleHandle(nullptr), nullptr);
     if (!hwnd) return;
 
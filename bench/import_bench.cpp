@@ -0,0 +1,358 @@
+// インポート全体のヘッドレスベンチマーク
+// モックのホスト (mock_host) に対して prepare_import_batch → 編集セクションごとの apply_import_step を実行し、
+// 段階ごとの所要時間と、キューあたりのホストAPI呼び出し回数を表示する。
+//
+// 使い方:
+//   import_bench [生成オプション] [--batch N] [--newline auto|raw|escaped|verify] [--reject-raw]
+//                [--latency API=us ...] [--layer N] [--pack N] [--trace FILE] [--update R] [--delete-between N] [--cancel-after N]
+//                [--merge-same] [--min-frames N] [--short-cues keep|drop|merge] [--files N] [--offset MS] [--stretch R]
+//   --files N: N 個のファイル (シードを変えて生成) を逐次と並行で準備し、連続したレイヤーへ1回の編集セクションで反映する
+//   --pack N: 重なるキューを最大 N レイヤーに振り分ける (--overlap と組み合わせる)
+//   --merge-same / --min-frames / --short-cues: 連続キューの結合 (--repeat-rate / --short と組み合わせる)
+//   --offset / --stretch: フレームへの変換の前に時刻を t * R + MS に変換する。
+//     0 より前に終わるキューだけが除かれ、残りがすべて生成されていなければ終了コード 1 を返す
+//   --update R: 取り込み後に R の割合のキューを変更 (本文・時刻・削除・追加) して差分更新し、その呼び出し回数も表示する。
+//     更新後のタイムラインが新しいキューと一致しなければ終了コード 1 を返す
+//     差分更新も --batch N なら N 件ずつ編集セクションを分ける
+//   --delete-between N: 差分更新の前に、取り込んだオブジェクトを N 個おきに手で消したことにする (--update と組み合わせる)
+//   --cancel-after N: 差分更新を N 回目の編集セクションの後で中止して記録し、その記録からもう一度差分更新する (--batch と組み合わせる)
+//   API: section create find layer_frame get set move delete
+//   例: import_bench --cues 100000 --batch 1000 --latency create=20 --latency set=5 --latency section=500
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#include "mock_host.h"
+#include "srt_import.h"
+#include "srt_synth.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed_ms(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static NewlineMode parse_newline_mode(const std::string& s) {
+    if (s == "raw") return NewlineMode::Raw;
+    if (s == "escaped") return NewlineMode::Escaped;
+    if (s == "verify") return NewlineMode::Verify;
+    return NewlineMode::Auto;
+}
+
+static ShortCueMode parse_short_mode(const std::string& s) {
+    if (s == "drop") return ShortCueMode::Drop;
+    if (s == "merge") return ShortCueMode::Merge;
+    return ShortCueMode::Keep;
+}
+
+static bool parse_latency(mock_host::Config& config, const std::string& spec) {
+    const size_t eq = spec.find('=');
+    if (eq == std::string::npos) return false;
+    const mock_host::Api api = mock_host::api_from_name(spec.substr(0, eq));
+    if (api == mock_host::ApiCount) return false;
+    config.latency_us[api] = std::atof(spec.c_str() + eq + 1);
+    return true;
+}
+
+// 反映の計測結果を表示する
+static void print_host_calls(size_t total) {
+    const auto& st = mock_host::stats();
+    const double per_cue = total ? 1.0 / (double)total : 0.0;
+    std::printf("\n%-12s %12s %10s %12s\n", "api", "calls", "per cue", "host ms");
+    for (int i = 0; i < mock_host::ApiCount; ++i) {
+        const auto api = (mock_host::Api)i;
+        std::printf("%-12s %12llu %10.3f %12.3f\n", mock_host::api_name(api),
+            (unsigned long long)st.calls[i], st.calls[i] * per_cue, st.host_ms[i]);
+    }
+    std::printf("%-12s %12llu %10.3f %12.3f\n", "total",
+        (unsigned long long)st.total_calls(true), st.total_calls(true) * per_cue, st.total_host_ms(true));
+}
+
+// 翻訳の手直しを模擬して、ratio の割合のキューを本文の変更・時刻の移動・長さの変更・削除・追加のいずれかで変える
+static SrtCues edit_cues(const SrtCues& cues, double ratio, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    SrtCues out;
+    for (size_t i = 0; i < cues.size(); ++i) {
+        const int64_t s = cues.start_ms[i], e = cues.end_ms[i];
+        const std::string_view text = cues.text(i);
+        if (unit(rng) >= ratio) {
+            out.push_back(s, e, text);
+            continue;
+        }
+        const int64_t next = i + 1 < cues.size() ? cues.start_ms[i + 1] : e + 1000;
+        switch (rng() % 5) {
+        case 0: out.push_back(s, e, std::string(text) + " (fixed)"); break;
+        case 1: { // 次のキューと重ならない範囲で後ろへずらす
+            const int64_t shift = std::max<int64_t>(0, std::min<int64_t>(100, next - e));
+            out.push_back(s + shift, e + shift, text);
+            break;
+        }
+        case 2: out.push_back(s, std::max(s + 1, e - 100), text); break;
+        case 3: break; // 削除
+        default: // 追加 (このキューの後ろに短いキューを足す)
+            out.push_back(s, e, text);
+            if (next - e > 40) out.push_back(e, e + (next - e) / 2, "inserted");
+            break;
+        }
+    }
+    return out;
+}
+
+static int usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s %s\n"
+        "          [--batch N] [--newline auto|raw|escaped|verify] [--reject-raw] [--latency API=us ...] [--layer N] [--pack N] [--trace FILE] [--update R]\n"
+        "          [--delete-between N] [--cancel-after N] [--merge-same] [--min-frames N] [--short-cues keep|drop|merge] [--files N] [--offset MS] [--stretch R]\n"
+        "  API: section create find layer_frame get set move delete\n", argv0, kGenOptionsUsage);
+    return 2;
+}
+
+// 複数ファイルのインポート: 準備を逐次と並行で比べ、SrtImporter と同じく各ファイルを前のファイルの次のレイヤーから置く
+static int run_files(const GenOptions& gen, const ImportOptions& options, const mock_host::Config& config, size_t files) {
+    std::vector<std::filesystem::path> paths;
+    for (size_t k = 0; k < files; ++k) {
+        GenOptions g = gen;
+        g.seed = gen.seed + (uint32_t)k;
+        paths.push_back(write_temp_srt(generate_srt(g), "files_" + std::to_string(k)));
+    }
+    auto make_batches = [&] {
+        std::vector<std::unique_ptr<ImportBatch>> batches;
+        for (const auto& path : paths) {
+            auto batch = std::make_unique<ImportBatch>();
+            batch->path = path;
+            batch->options = options;
+            batch->options.use_cache = false;
+            batch->style.font = "Yu Gothic UI";
+            batches.push_back(std::move(batch));
+        }
+        return batches;
+    };
+
+    auto serial = make_batches();
+    auto t0 = Clock::now();
+    prepare_import_batches(serial, 1);
+    const double serial_ms = elapsed_ms(t0);
+    auto batches = make_batches();
+    t0 = Clock::now();
+    prepare_import_batches(batches);
+    const double parallel_ms = elapsed_ms(t0);
+
+    HOST_APP_TABLE* host = mock_host::create_host(config);
+    EDIT_HANDLE* edit = host->create_edit_handle();
+    set_import_logger(mock_host::logger());
+    struct Job {
+        std::vector<std::unique_ptr<ImportBatch>>* batches;
+        std::vector<int> layers;
+        size_t inserted = 0;
+    } job{ &batches, {}, 0 };
+    t0 = Clock::now();
+    edit->call_edit_section_param(&job, [](void* param, EDIT_SECTION* section) {
+        auto& j = *(Job*)param;
+        int next_layer = (*j.batches)[0]->options.layer;
+        for (auto& batch : *j.batches) {
+            batch->options.layer = next_layer;
+            ImportProgress progress;
+            while (progress.next < batch->cues.size()) apply_import_step(*batch, progress, section);
+            j.layers.push_back(batch->options.layer);
+            j.inserted += progress.inserted;
+            next_layer += used_layer_count(*batch, progress);
+        }
+    });
+    const double apply_ms = elapsed_ms(t0);
+
+    std::printf("# files=%zu inserted=%zu warn=%llu layers=", files, job.inserted, (unsigned long long)mock_host::stats().log_warn);
+    for (size_t k = 0; k < job.layers.size(); ++k) std::printf("%s%d", k ? "," : "", job.layers[k]);
+    std::printf("\n%-16s %12s\n", "phase", "ms");
+    std::printf("%-16s %12.3f\n", "prepare serial", serial_ms);
+    std::printf("%-16s %12.3f\n", "prepare pool", parallel_ms);
+    std::printf("%-16s %12.3f\n", "apply", apply_ms);
+    std::error_code ec;
+    for (const auto& path : paths) std::filesystem::remove(path, ec);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    GenOptions gen;
+    ImportOptions options;
+    mock_host::Config config;
+    std::string trace_path;
+    double update_ratio = -1.0;
+    size_t delete_stride = 0;
+    size_t cancel_after = 0;
+    size_t files = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (parse_gen_option(gen, argc, argv, i)) continue;
+        const bool has_value = i + 1 < argc;
+        if (a == "--batch" && has_value) options.batch_size = std::atoi(argv[++i]);
+        else if (a == "--layer" && has_value) options.layer = std::atoi(argv[++i]);
+        else if (a == "--merge-same") options.coalesce.merge_identical = true;
+        else if (a == "--min-frames" && has_value) options.coalesce.min_frames = std::atoi(argv[++i]);
+        else if (a == "--short-cues" && has_value) options.coalesce.short_mode = parse_short_mode(argv[++i]);
+        else if (a == "--pack" && has_value) {
+            options.pack_layers = true;
+            options.max_layers = std::atoi(argv[++i]);
+        }
+        else if (a == "--newline" && has_value) options.newline_mode = parse_newline_mode(argv[++i]);
+        else if (a == "--trace" && has_value) trace_path = argv[++i];
+        else if (a == "--update" && has_value) update_ratio = std::atof(argv[++i]);
+        else if (a == "--delete-between" && has_value) delete_stride = (size_t)std::atoi(argv[++i]);
+        else if (a == "--cancel-after" && has_value) cancel_after = (size_t)std::atoi(argv[++i]);
+        else if (a == "--files" && has_value) files = (size_t)std::atoi(argv[++i]);
+        else if (a == "--offset" && has_value) options.timing.offset_ms = std::atof(argv[++i]);
+        else if (a == "--stretch" && has_value) options.timing.scale = std::atof(argv[++i]);
+        else if (a == "--reject-raw") config.reject_raw_newline = true;
+        else if (a == "--latency" && has_value) {
+            if (!parse_latency(config, argv[++i])) return usage(argv[0]);
+        }
+        else return usage(argv[0]);
+    }
+
+    if (files > 0) return run_files(gen, options, config, files);
+
+    const std::string srt = generate_srt(gen);
+    const auto path = write_temp_srt(srt, "import_" + std::to_string(gen.seed));
+
+    // プラグインと同じくホストのテーブルから編集ハンドルを得る
+    HOST_APP_TABLE* host = mock_host::create_host(config);
+    EDIT_HANDLE* edit = host->create_edit_handle();
+    set_import_logger(mock_host::logger());
+
+    ImportBatch batch;
+    batch.path = path;
+    batch.options = options;
+    batch.options.use_cache = false; // 毎回生成し直すファイルなのでキャッシュは使わない
+    batch.style.font = "Yu Gothic UI";
+
+    auto t0 = Clock::now();
+    prepare_import_batch(batch);
+    const double prepare_ms = elapsed_ms(t0);
+    const size_t total = batch.cues.size();
+
+    // SrtImporter の run_import_step と同じく batch_size 件ずつ編集セクションを呼ぶ
+    struct Step {
+        ImportBatch* batch;
+        ImportProgress progress;
+    } step{ &batch, {} };
+    size_t sections = 0;
+    t0 = Clock::now();
+    while (step.progress.next < batch.cues.size()) { // 初回の反映で結合されると件数が減る
+        const size_t before = step.progress.next;
+        edit->call_edit_section_param(&step, [](void* param, EDIT_SECTION* section) {
+            auto& s = *(Step*)param;
+            apply_import_step(*s.batch, s.progress, section);
+        });
+        ++sections;
+        if (step.progress.next == before) break;
+    }
+    const double apply_ms = elapsed_ms(t0);
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    const auto& st = mock_host::stats();
+    const double host_ms = st.total_host_ms(true);
+    const CoalesceStats& cs = step.progress.coalesce;
+    std::printf("# cues=%zu bytes=%zu batch=%d sections=%zu inserted=%zu overflow=%zu warn=%llu\n",
+        total, srt.size(), options.batch_size, sections, step.progress.inserted, step.progress.overflow, (unsigned long long)st.log_warn);
+    if (options.coalesce.enabled()) {
+        std::printf("# coalesce saved=%zu identical=%zu dropped=%zu merged_short=%zu\n",
+            cs.saved(), cs.merged_identical, cs.dropped, cs.merged_short);
+    }
+    // 時刻の変換: 変換後に 0 より前に終わるキューだけが除かれ、残りはすべて生成できたか (結合しない場合だけ数を比べる)
+    bool retime_ok = true;
+    if (!options.timing.identity() && !options.coalesce.enabled()) {
+        const SrtCues original = parse_srt_buffer(srt);
+        size_t expect = 0;
+        for (int64_t end : original.end_ms) expect += std::nearbyint((double)end * options.timing.scale + options.timing.offset_ms) > 0 ? 1 : 0;
+        const uint64_t create_failed = batch.metrics.api_failures[ImportMetrics::ApiCreateObject];
+        retime_ok = total == expect && create_failed == 0 && step.progress.inserted + step.progress.overflow == total;
+        std::printf("# retime scale=%.6f offset=%.3f kept=%zu dropped=%zu create_failed=%llu ok=%s\n", options.timing.scale, options.timing.offset_ms,
+            total, original.size() - total, (unsigned long long)create_failed, retime_ok ? "yes" : "no");
+    }
+    std::printf("%-10s %12s\n", "phase", "ms");
+    std::printf("%-10s %12.3f\n", "prepare", prepare_ms);
+    std::printf("%-10s %12.3f\n", "apply", apply_ms);
+    std::printf("%-10s %12.3f\n", " host", host_ms);
+    std::printf("%-10s %12.3f\n", " plugin", apply_ms - host_ms);
+    std::printf("%-10s %12.3f\n", "total", prepare_ms + apply_ms);
+    print_host_calls(total);
+
+    // プラグインがログへ出すものと同じ要約
+    std::printf("\n%ls\n", format_import_metrics(batch.metrics).c_str());
+    if (!trace_path.empty() && !write_import_trace(batch.metrics, trace_path)) {
+        std::fprintf(stderr, "failed to write %s\n", trace_path.c_str());
+        return 1;
+    }
+
+    if (update_ratio >= 0.0) {
+        // 前回の取り込みと比較して差分だけを反映する
+        ImportedLayer previous = record_imported_layer(batch, step.progress);
+        ImportBatch updated;
+        updated.options = batch.options;
+        updated.alias = batch.alias;
+        updated.cues = edit_cues(batch.cues, update_ratio, gen.seed + 1);
+        ImportProgress progress;
+        // 前回のハンドルが無効になっていても、差分更新は消えたキューを作り直す
+        const size_t deleted_by_hand = mock_host::delete_objects_by_hand(delete_stride);
+        mock_host::reset_stats();
+        struct Update {
+            ImportBatch* batch;
+            ImportedLayer* previous;
+            ImportProgress* progress;
+        } u{ &updated, &previous, &progress };
+        // 取り込みと同じく batch_size 件ずつ編集セクションを呼ぶ
+        size_t update_sections = 0;
+        t0 = Clock::now();
+        do {
+            const size_t before = progress.plan.work_done;
+            edit->call_edit_section_param(&u, [](void* param, EDIT_SECTION* section) {
+                auto& x = *(Update*)param;
+                apply_update(*x.batch, *x.previous, *x.progress, section);
+            });
+            ++update_sections;
+            if (progress.plan.started() && progress.plan.work_done == before && !progress.plan.done()) break;
+            if (cancel_after > 0 && update_sections == cancel_after && !progress.plan.done()) {
+                // SrtImporter の中止と同じく途中までの状態を記録し、その記録に対してもう一度差分更新する
+                previous = record_imported_layer(updated, progress);
+                progress = {};
+                cancel_after = 0;
+            }
+        } while (!progress.plan.done());
+        const double update_ms = elapsed_ms(t0);
+        // 更新後のタイムラインが、新しいキューを最初から取り込んだ場合と一致するか (本文は実改行で比較する)
+        // --pack ではレイヤーも比較し、上限に収まらないキューは除く
+        std::vector<std::tuple<int, int, int, std::string>> expect, actual;
+        const int base_layer = std::max(0, options.layer - 1);
+        for (size_t i = 0; i < updated.cues.size(); ++i) {
+            const int layer = options.pack_layers ? progress.layers[i] : 0;
+            if (layer < 0) continue;
+            expect.emplace_back(base_layer + layer, updated.cues.start_frame[i],
+                std::max(updated.cues.start_frame[i] + 1, updated.cues.end_frame[i]) - 1, std::string(updated.cues.text(i)));
+        }
+        for (const auto& o : mock_host::objects()) {
+            if (o.alive) actual.emplace_back(o.layer, o.start, o.end, o.text);
+        }
+        std::sort(expect.begin(), expect.end());
+        std::sort(actual.begin(), actual.end());
+        const UpdateStats& us = progress.update;
+        const bool match = config.reject_raw_newline || expect == actual;
+        std::printf("\n# update ratio=%.3f cues=%zu sections=%zu ms=%.3f by_hand=%zu kept=%zu text=%zu moved=%zu recreated=%zu deleted=%zu created=%zu objects=%zu match=%s\n",
+            update_ratio, updated.cues.size(), update_sections, update_ms, deleted_by_hand, us.kept, us.retexted, us.moved, us.recreated, us.deleted, us.created,
+            (size_t)std::count_if(mock_host::objects().begin(), mock_host::objects().end(), [](const mock_host::Object& o) { return o.alive; }),
+            config.reject_raw_newline ? "-" : match ? "yes" : "no");
+        print_host_calls(updated.cues.size());
+        if (!match) return 1;
+    }
+    return retime_ok ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include "mock_host.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <map>
+
+namespace mock_host {
+
+using Clock = std::chrono::steady_clock;
+
+static Config g_config;
+static Stats g_stats;
+static std::vector<Object> g_objects;
+static std::vector<std::map<int, size_t>> g_layers; // レイヤーごとに 開始フレーム→オブジェクト番号
+static EDIT_INFO g_info{};
+static EDIT_SECTION g_section{};
+static EDIT_HANDLE g_edit{};
+static HOST_APP_TABLE g_host{};
+static LOG_HANDLE g_logger{};
+
+static const char* const kApiNames[ApiCount] = {
+    "section", "create", "find", "layer_frame", "get", "set", "move", "delete",
+};
+
+const char* api_name(Api api) {
+    return api < ApiCount ? kApiNames[api] : "?";
+}
+
+Api api_from_name(const std::string& name) {
+    for (int i = 0; i < ApiCount; ++i) {
+        if (name == kApiNames[i]) return (Api)i;
+    }
+    return ApiCount;
+}
+
+uint64_t Stats::total_calls(bool include_sections) const {
+    uint64_t n = 0;
+    for (int i = include_sections ? 0 : 1; i < ApiCount; ++i) n += calls[i];
+    return n;
+}
+
+double Stats::total_host_ms(bool include_sections) const {
+    double ms = 0.0;
+    for (int i = include_sections ? 0 : 1; i < ApiCount; ++i) ms += host_ms[i];
+    return ms;
+}
+
+//---------------------------------------------------------------------
+// 呼び出しの記録と遅延
+//---------------------------------------------------------------------
+static void spin_until(Clock::time_point deadline) {
+    while (Clock::now() < deadline) {
+    }
+}
+
+// API 1回分。生成時に回数を数え、破棄時に遅延を待ってからホスト側の時間を積算する。
+class CallScope {
+public:
+    explicit CallScope(Api api) : api_(api), t0_(Clock::now()) { ++g_stats.calls[api]; }
+    ~CallScope() {
+        const double latency = g_config.latency_us[api_];
+        if (latency > 0) spin_until(t0_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(latency)));
+        g_stats.host_ms[api_] += std::chrono::duration<double, std::milli>(Clock::now() - t0_).count();
+    }
+    CallScope(const CallScope&) = delete;
+    CallScope& operator=(const CallScope&) = delete;
+
+private:
+    Api api_;
+    Clock::time_point t0_;
+};
+
+//---------------------------------------------------------------------
+// オブジェクト管理
+//---------------------------------------------------------------------
+static Object* from_handle(OBJECT_HANDLE obj) {
+    const size_t index = (size_t)(uintptr_t)obj;
+    if (index == 0 || index > g_objects.size()) return nullptr;
+    Object& o = g_objects[index - 1];
+    return o.alive ? &o : nullptr;
+}
+
+static OBJECT_HANDLE to_handle(size_t index) {
+    return (OBJECT_HANDLE)(uintptr_t)(index + 1);
+}
+
+static std::map<int, size_t>& layer_map(int layer) {
+    if ((size_t)layer >= g_layers.size()) g_layers.resize((size_t)layer + 1);
+    return g_layers[(size_t)layer];
+}
+
+// [start, end] が layer 上の既存オブジェクト (ignore を除く) と重なるか
+static bool overlaps(int layer, int start, int end, size_t ignore) {
+    auto& m = layer_map(layer);
+    auto it = m.upper_bound(end);
+    while (it != m.begin()) {
+        --it;
+        if (it->second == ignore) continue;
+        return g_objects[it->second].end >= start;
+    }
+    return false;
+}
+
+static bool is_text_item(LPCWSTR item) {
+    return item && std::wcscmp(item, L"テキスト") == 0;
+}
+
+//---------------------------------------------------------------------
+// EDIT_SECTION
+//---------------------------------------------------------------------
+static OBJECT_HANDLE create_object_from_alias(LPCSTR alias, int layer, int frame, int length) {
+    CallScope call(ApiCreateObject);
+    if (!alias || layer < 0 || frame < 0 || length <= 0) return nullptr;
+    const int end = frame + length - 1;
+    if (overlaps(layer, frame, end, (size_t)-1)) return nullptr;
+    Object o;
+    o.layer = layer;
+    o.start = frame;
+    o.end = end;
+    g_objects.push_back(std::move(o));
+    layer_map(layer)[frame] = g_objects.size() - 1;
+    return to_handle(g_objects.size() - 1);
+}
+
+static OBJECT_HANDLE find_object(int layer, int frame) {
+    CallScope call(ApiFindObject);
+    if (layer < 0) return nullptr;
+    auto& m = layer_map(layer);
+    auto it = m.upper_bound(frame);
+    if (it == m.begin()) return nullptr;
+    --it;
+    return g_objects[it->second].end >= frame ? to_handle(it->second) : nullptr;
+}
+
+static OBJECT_LAYER_FRAME get_object_layer_frame(OBJECT_HANDLE obj) {
+    CallScope call(ApiGetLayerFrame);
+    OBJECT_LAYER_FRAME lf{};
+    if (const Object* o = from_handle(obj)) {
+        lf.layer = o->layer;
+        lf.start = o->start;
+        lf.end = o->end;
+    }
+    return lf;
+}
+
+static LPCSTR get_object_item_value(OBJECT_HANDLE obj, LPCWSTR effect, LPCWSTR item) {
+    CallScope call(ApiGetItemValue);
+    (void)effect;
+    const Object* o = from_handle(obj);
+    if (!o || !is_text_item(item)) return nullptr;
+    return o->text.c_str();
+}
+
+static bool set_object_item_value(OBJECT_HANDLE obj, LPCWSTR effect, LPCWSTR item, LPCSTR value) {
+    CallScope call(ApiSetItemValue);
+    (void)effect;
+    Object* o = from_handle(obj);
+    if (!o || !value) return false;
+    if (!is_text_item(item)) return true;
+    o->text = value;
+    if (g_config.reject_raw_newline) {
+        o->text.erase(std::remove(o->text.begin(), o->text.end(), '\n'), o->text.end());
+    }
+    return true;
+}
+
+static bool move_object(OBJECT_HANDLE obj, int layer, int frame) {
+    CallScope call(ApiMoveObject);
+    Object* o = from_handle(obj);
+    if (!o || layer < 0 || frame < 0) return false;
+    const size_t index = (size_t)(o - g_objects.data());
+    const int end = frame + (o->end - o->start);
+    if (overlaps(layer, frame, end, index)) return false;
+    layer_map(o->layer).erase(o->start);
+    o->layer = layer;
+    o->start = frame;
+    o->end = end;
+    layer_map(layer)[frame] = index;
+    return true;
+}
+
+static void delete_object(OBJECT_HANDLE obj) {
+    CallScope call(ApiDeleteObject);
+    Object* o = from_handle(obj);
+    if (!o) return;
+    layer_map(o->layer).erase(o->start);
+    o->alive = false;
+    o->text.clear();
+}
+
+//---------------------------------------------------------------------
+// EDIT_HANDLE / HOST_APP_TABLE / LOG_HANDLE
+//---------------------------------------------------------------------
+// 編集セクションの往復コストとして遅延だけをホスト時間に数える (コールバック内はプラグイン側の時間)
+static void enter_edit_section() {
+    CallScope call(ApiEditSection);
+}
+
+static bool call_edit_section(void (*func_proc_edit)(EDIT_SECTION* edit)) {
+    enter_edit_section();
+    func_proc_edit(&g_section);
+    return true;
+}
+
+static bool call_edit_section_param(void* param, void (*func_proc_edit)(void* param, EDIT_SECTION* edit)) {
+    enter_edit_section();
+    func_proc_edit(param, &g_section);
+    return true;
+}
+
+static EDIT_HANDLE* create_edit_handle() {
+    return &g_edit;
+}
+
+// 登録系はヘッドレスでは何もしない
+static void set_plugin_information(LPCWSTR) {}
+static void register_import_menu(LPCWSTR, void (*)(EDIT_SECTION*)) {}
+static void register_config_menu(LPCWSTR, void (*)(HWND, HINSTANCE)) {}
+static void register_window_client(LPCWSTR, HWND) {}
+static void register_project_load_handler(void (*)(PROJECT_FILE*)) {}
+
+static void log_info(LOG_HANDLE*, LPCWSTR) { ++g_stats.log_info; }
+static void log_warn(LOG_HANDLE*, LPCWSTR) { ++g_stats.log_warn; }
+
+HOST_APP_TABLE* create_host(const Config& config) {
+    g_config = config;
+    g_info = EDIT_INFO{};
+    g_info.rate = config.rate;
+    g_info.scale = config.scale;
+
+    g_section = EDIT_SECTION{};
+    g_section.info = &g_info;
+    g_section.create_object_from_alias = create_object_from_alias;
+    g_section.find_object = find_object;
+    g_section.get_object_layer_frame = get_object_layer_frame;
+    g_section.get_object_item_value = get_object_item_value;
+    g_section.set_object_item_value = set_object_item_value;
+    g_section.move_object = move_object;
+    g_section.delete_object = delete_object;
+
+    g_edit = EDIT_HANDLE{};
+    g_edit.call_edit_section = call_edit_section;
+    g_edit.call_edit_section_param = call_edit_section_param;
+
+    g_host = HOST_APP_TABLE{};
+    g_host.create_edit_handle = create_edit_handle;
+    g_host.set_plugin_information = set_plugin_information;
+    g_host.register_import_menu = register_import_menu;
+    g_host.register_config_menu = register_config_menu;
+    g_host.register_window_client = register_window_client;
+    g_host.register_project_load_handler = register_project_load_handler;
+
+    g_logger = LOG_HANDLE{};
+    g_logger.info = log_info;
+    g_logger.warn = log_warn;
+    g_logger.log = log_info;
+    g_logger.verbose = log_info;
+    g_logger.error = log_warn;
+
+    reset_stats();
+    clear_objects();
+    return &g_host;
+}
+
+LOG_HANDLE* logger() {
+    return &g_logger;
+}
+
+Stats& stats() {
+    return g_stats;
+}
+
+void reset_stats() {
+    g_stats = Stats{};
+}
+
+const std::vector<Object>& objects() {
+    return g_objects;
+}
+
+void clear_objects() {
+    g_objects.clear();
+    g_layers.clear();
+}
+
+size_t delete_objects_by_hand(size_t stride) {
+    if (stride == 0) return 0;
+    size_t alive = 0, removed = 0;
+    for (auto& o : g_objects) {
+        if (!o.alive || alive++ % stride != 0) continue;
+        layer_map(o.layer).erase(o.start);
+        o.alive = false;
+        o.text.clear();
+        ++removed;
+    }
+    return removed;
+}
+
+} // namespace mock_host
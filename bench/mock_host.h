@@ -0,0 +1,68 @@
+#pragma once
+
+// ヘッドレス実行用のホストのモック
+// HOST_APP_TABLE / EDIT_HANDLE / EDIT_SECTION を plugin2.h の型のまま実装し、
+// API ごとの呼び出し回数とホスト内で費やした時間を記録する。
+// 呼び出しごとに遅延 (ビジーウェイト) を入れて、実ホストの往復コストを模擬できる。
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "srt_import.h"
+
+namespace mock_host {
+
+enum Api {
+    ApiEditSection,
+    ApiCreateObject,
+    ApiFindObject,
+    ApiGetLayerFrame,
+    ApiGetItemValue,
+    ApiSetItemValue,
+    ApiMoveObject,
+    ApiDeleteObject,
+    ApiCount,
+};
+
+const char* api_name(Api api);
+// "create" などの短い名前から Api を引く (見つからなければ ApiCount)
+Api api_from_name(const std::string& name);
+
+struct Object {
+    int layer = 0;
+    int start = 0;
+    int end = 0; // 終了フレーム (含む)
+    std::string text;
+    bool alive = true;
+};
+
+struct Stats {
+    uint64_t calls[ApiCount] = {};
+    double host_ms[ApiCount] = {}; // 遅延を含むホスト側の所要時間
+    uint64_t log_warn = 0;
+    uint64_t log_info = 0;
+
+    uint64_t total_calls(bool include_sections) const;
+    double total_host_ms(bool include_sections) const;
+};
+
+struct Config {
+    int rate = 30000;
+    int scale = 1001;
+    double latency_us[ApiCount] = {};
+    bool reject_raw_newline = false; // 実改行を受け付けないホストを模擬する (設定時に LF を落とす)
+};
+
+// モックを初期化してホストのテーブルを返す (プロセスで1つ)
+HOST_APP_TABLE* create_host(const Config& config);
+LOG_HANDLE* logger();
+
+Stats& stats();
+void reset_stats();
+const std::vector<Object>& objects();
+void clear_objects();
+// 利用者がタイムライン上で手で消したことにする: 残っているオブジェクトを stride 個おきに削除する (API 呼び出しには数えない)
+size_t delete_objects_by_hand(size_t stride);
+
+} // namespace mock_host
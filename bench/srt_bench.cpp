@@ -0,0 +1,246 @@
+// srt_core ベンチマーク
+// 合成した SRT に対して、読み込み・パース (一括と流し読み)・文字コードの判定と UTF-16 からの変換・時刻の変換・フレーム変換・本文エスケープ・alias生成・レイヤー割り当て・パースキャッシュ・
+// 時刻範囲の読み込み (シーク索引の作成と、中央 1% の範囲のパース) の各段階の処理量 (MB/s, cues/s)、確保回数、ピークRSS を計測する。AviUtl 本体は不要。
+//
+// 使い方:
+//   srt_bench [--cues N] [--eol lf|crlf|cr|mixed] [--multiline R] [--bom] [--malformed R]
+//             [--overlap R] [--repeat-rate R] [--short R] [--seed N] [--repeat N] [--sweep]
+//   --sweep を付けると 1k / 10k / 100k / 1M キューを順に計測する (他の指定はそのまま使う)。
+//   --repeat N は各段階の計測回数 (生成オプションの --repeat-rate とは別)。
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "srt_core.h"
+#include "srt_cache.h"
+#include "srt_synth.h"
+
+//---------------------------------------------------------------------
+// 確保回数の計測 (グローバル operator new を置き換える)
+//---------------------------------------------------------------------
+static std::atomic<uint64_t> g_alloc_count{ 0 };
+static std::atomic<uint64_t> g_alloc_bytes{ 0 };
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+// プロセスのピーク常駐メモリ (KB)
+static uint64_t peak_rss_kb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    pmc.cb = sizeof(pmc);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (uint64_t)pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)ru.ru_maxrss / 1024; // macOS はバイト単位
+#else
+    return (uint64_t)ru.ru_maxrss;
+#endif
+#endif
+}
+
+//---------------------------------------------------------------------
+// 計測
+//---------------------------------------------------------------------
+struct StageResult {
+    const char* name;
+    double ms = 0.0;
+    uint64_t allocs = 0;
+    uint64_t alloc_bytes = 0;
+    uint64_t peak_rss_kb = 0;
+};
+
+template <class F>
+static StageResult measure(const char* name, int repeat, F&& fn) {
+    StageResult r{ name };
+    r.ms = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        uint64_t c0 = g_alloc_count.load(), b0 = g_alloc_bytes.load();
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        auto t1 = std::chrono::steady_clock::now();
+        r.ms = std::min(r.ms, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        r.allocs = g_alloc_count.load() - c0;
+        r.alloc_bytes = g_alloc_bytes.load() - b0;
+    }
+    r.peak_rss_kb = peak_rss_kb();
+    return r;
+}
+
+static void print_header() {
+    std::printf("%-10s %10s %10s %10s %12s %10s %14s %12s\n",
+        "stage", "cues", "MB", "ms", "MB/s", "Mcues/s", "allocs", "peakRSS(MB)");
+}
+
+static void print_result(const StageResult& r, size_t cues, size_t bytes) {
+    const double sec = r.ms / 1000.0;
+    const double mb = bytes / (1024.0 * 1024.0);
+    std::printf("%-10s %10zu %10.1f %10.3f %12.1f %10.2f %14llu %12.1f\n",
+        r.name, cues, mb, r.ms, sec > 0 ? mb / sec : 0.0, sec > 0 ? cues / sec / 1e6 : 0.0,
+        (unsigned long long)r.allocs, r.peak_rss_kb / 1024.0);
+}
+
+static void run_case(const GenOptions& opt, int repeat) {
+    const std::string srt = generate_srt(opt);
+    std::printf("\n# cues=%zu eol=%s multiline=%.2f bom=%d malformed=%.3f overlap=%.3f bytes=%zu\n",
+        opt.cues, eol_name(opt.eol), opt.multiline_ratio, opt.bom ? 1 : 0, opt.malformed_rate, opt.overlap_rate, srt.size());
+
+    // 読み込み段階はファイル経由 (メモリマップ) で計測する
+    const auto path = write_temp_srt(srt, std::to_string(opt.seed));
+
+    print_header();
+    uint64_t checksum = 0;
+    auto read = measure("read", repeat, [&] {
+        SrtInputFile in;
+        if (!in.open(path)) return;
+        // 全ページに触れて実際の読み込みを含める
+        auto bytes = in.bytes();
+        for (size_t i = 0; i < bytes.size(); i += 4096) checksum += (unsigned char)bytes[i];
+    });
+    print_result(read, opt.cues, srt.size());
+
+    SrtCues cues;
+    auto parse = measure("parse", repeat, [&] { cues = parse_srt_buffer(srt); });
+    print_result(parse, cues.size(), srt.size());
+
+    // 流し読み: ファイルから固定サイズずつ読んでキューを1つずつ受け取る (キューは保持しない)
+    size_t streamed = 0;
+    auto stream = measure("stream", repeat, [&] {
+        streamed = 0;
+        parse_srt_stream(path, [&](const SrtCueView& cue) {
+            checksum += cue.text.size();
+            ++streamed;
+            return true;
+        });
+    });
+    print_result(stream, streamed, srt.size());
+
+    auto serial = measure("parse1", repeat, [&] {
+        SrtCues one = parse_srt_parallel(strip_utf8_bom(srt), 1);
+        checksum += one.size();
+    });
+    print_result(serial, cues.size(), srt.size());
+
+    // 文字コードの判定 (BOM の無い UTF-8 の通常経路で払う検証の走査) と、UTF-16LE からの変換
+    const std::string_view body = strip_utf8_bom(srt);
+    auto detect = measure("detect", repeat, [&] { checksum += (uint64_t)detect_srt_encoding(body); });
+    print_result(detect, cues.size(), body.size());
+    const std::string utf16 = to_utf16le(srt);
+    std::string decoded;
+    auto utf16_to_8 = measure("utf16", repeat, [&] {
+        std::string_view text;
+        decode_srt_text(utf16, decoded, text);
+        checksum += text.size();
+    });
+    print_result(utf16_to_8, cues.size(), utf16.size());
+
+    // 時刻範囲の読み込み: 全体の中央 1% の時間だけを取り出す
+    SrtSeekIndex index;
+    auto indexing = measure("index", repeat, [&] { index = build_seek_index(body); });
+    print_result(indexing, cues.size(), body.size());
+    const int64_t last_end = cues.empty() ? 0 : *std::max_element(cues.end_ms.begin(), cues.end_ms.end());
+    const int64_t win_begin = last_end / 2, win_end = win_begin + std::max<int64_t>(1, last_end / 100);
+    SrtCues window;
+    auto windowed = measure("window", repeat, [&] { window = parse_srt_window(body, index, win_begin, win_end); });
+    print_result(windowed, window.size(), body.size());
+
+    // 時刻の変換 (25fps 基準 → 23.976fps と、0.5秒前へずらす) を複製したキューに対して計測する
+    SrtCues retimed = cues;
+    auto retime = measure("retime", repeat, [&] { apply_timing_transform(retimed, TimingTransform{ 25.0 / 23.976, -500.0 }); });
+    print_result(retime, retimed.size(), retimed.size() * sizeof(int64_t) * 2);
+
+    auto frames = measure("frames", repeat, [&] { assign_frames(cues, 30000, 1001); });
+    print_result(frames, cues.size(), cues.size() * sizeof(int64_t) * 2);
+
+    auto layers = measure("layers", repeat, [&] { checksum += assign_cue_layers(cues, 8).size(); });
+    print_result(layers, cues.size(), cues.size() * sizeof(int) * 2);
+
+    std::string scratch;
+    auto escape = measure("escape", repeat, [&] {
+        for (size_t i = 0; i < cues.size(); ++i) {
+            escape_text_value_newline(cues.text(i), scratch);
+            checksum += scratch.size();
+        }
+    });
+    print_result(escape, cues.size(), cues.arena.size());
+
+    AliasStyle style;
+    style.font = "Yu Gothic UI";
+    AliasTemplate alias;
+    auto build = measure("alias", repeat, [&] { alias = build_alias(style); });
+    print_result(build, 1, alias.text.size());
+
+    // パースキャッシュ: 書き込みと、ハッシュ計算込みの読み込み (再インポート時の経路)
+    const SrtParseCache cache(std::filesystem::temp_directory_path() / "srt_bench_cache");
+    SrtCacheKey key;
+    make_srt_cache_key(path, srt, key);
+    auto store = measure("cache_st", repeat, [&] { cache.store(key, cues); });
+    print_result(store, cues.size(), srt.size());
+    SrtCues cached;
+    auto load = measure("cache_ld", repeat, [&] {
+        SrtInputFile in;
+        if (!in.open(path)) return;
+        SrtCacheKey k;
+        if (make_srt_cache_key(path, in.bytes(), k) && cache.load(k, cached)) checksum += cached.size();
+    });
+    print_result(load, cached.size(), srt.size());
+
+    std::error_code ec;
+    std::filesystem::remove_all(cache.dir(), ec);
+    std::filesystem::remove(path, ec);
+    std::printf("# parsed=%zu checksum=%llu\n", cues.size(), (unsigned long long)checksum);
+}
+
+int main(int argc, char** argv) {
+    GenOptions opt;
+    int repeat = 3;
+    bool sweep = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (parse_gen_option(opt, argc, argv, i)) continue;
+        if (a == "--repeat" && i + 1 < argc) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--sweep") sweep = true;
+        else {
+            std::fprintf(stderr, "usage: %s %s [--repeat N] [--sweep]\n", argv[0], kGenOptionsUsage);
+            return 2;
+        }
+    }
+
+    if (sweep) {
+        for (size_t n : { (size_t)1000, (size_t)10000, (size_t)100000, (size_t)1000000 }) {
+            GenOptions o = opt;
+            o.cues = n;
+            run_case(o, repeat);
+        }
+    } else {
+        run_case(opt, repeat);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "srt_synth.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const char kGenOptionsUsage[] = "[--cues N] [--eol lf|crlf|cr|mixed] [--multiline R] [--bom|--no-bom] [--malformed R] [--overlap R] [--repeat-rate R] [--short R] [--seed N]";
+
+const char* eol_name(Eol e) {
+    switch (e) {
+    case Eol::Lf: return "lf";
+    case Eol::Crlf: return "crlf";
+    case Eol::Cr: return "cr";
+    case Eol::Mixed: return "mixed";
+    }
+    return "?";
+}
+
+static void append_timestamp(std::string& out, int64_t ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%02lld:%02lld:%02lld,%03lld",
+        (long long)(ms / 3600000), (long long)(ms / 60000 % 60), (long long)(ms / 1000 % 60), (long long)(ms % 1000));
+    out += buf;
+}
+
+std::string generate_srt(const GenOptions& opt) {
+    std::mt19937 rng(opt.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    static const char* const kWords[] = {
+        "字幕", "テスト", "こんにちは", "subtitle", "the", "quick", "brown", "fox", "\\N", "<i>", "</i>", "…",
+    };
+    const size_t word_count = sizeof(kWords) / sizeof(kWords[0]);
+
+    std::string out;
+    out.reserve(opt.cues * 64);
+    if (opt.bom) out += "\xEF\xBB\xBF";
+
+    // mixed の場合、CR の直後に LF を置くと CRLF 1個に化けるので避ける
+    Eol last = Eol::Lf;
+    auto eol = [&] {
+        Eol e = opt.eol;
+        if (e == Eol::Mixed) {
+            e = (Eol)(rng() % 3);
+            if (last == Eol::Cr && e == Eol::Lf) e = Eol::Cr;
+        }
+        last = e;
+        switch (e) {
+        case Eol::Lf: out += '\n'; break;
+        case Eol::Crlf: out += "\r\n"; break;
+        default: out += '\r'; break;
+        }
+    };
+    // 直前の本文の行 (repeat_rate 用)
+    std::vector<std::string> prev_text, text;
+    auto text_line = [&] {
+        std::string line;
+        int words = 2 + (int)(rng() % 6);
+        for (int w = 0; w < words; ++w) {
+            if (w) line += ' ';
+            line += kWords[rng() % word_count];
+        }
+        text.push_back(line);
+    };
+
+    int64_t prev_end = 0;
+    for (size_t i = 0; i < opt.cues; ++i) {
+        // 通常は直前のキューの終了後に始める。overlap_rate の割合で直前のキューと重ねる。
+        int64_t t = prev_end + rng() % 800;
+        if (i > 0 && unit(rng) < opt.overlap_rate) t = std::max<int64_t>(0, prev_end - 200 - rng() % 2000);
+        int64_t end = t + 500 + rng() % 4000;
+        const bool repeat = i > 0 && !prev_text.empty() && opt.repeat_rate > 0 && unit(rng) < opt.repeat_rate;
+        if (repeat) {
+            t = prev_end;
+            end = t + 200 + rng() % 1500;
+        }
+        if (opt.short_rate > 0 && unit(rng) < opt.short_rate) {
+            t = prev_end;
+            end = t + 1 + rng() % 30;
+        }
+        prev_end = std::max(prev_end, end);
+        out += std::to_string(i + 1);
+        eol();
+
+        int kind = unit(rng) < opt.malformed_rate ? 1 + (int)(rng() % 4) : 0;
+        switch (kind) {
+        case 1: // 時刻行が無い
+            break;
+        case 2: // 時刻が壊れている
+            out += "00:xx:00,000 --> 00:00:01,000";
+            eol();
+            break;
+        case 3: // 終了が開始以前
+            append_timestamp(out, end);
+            out += " --> ";
+            append_timestamp(out, t);
+            eol();
+            break;
+        default:
+            append_timestamp(out, t);
+            out += " --> ";
+            append_timestamp(out, end);
+            eol();
+            break;
+        }
+        if (kind != 4) { // 4: 本文が無い
+            text.clear();
+            if (repeat) {
+                text = prev_text;
+            } else {
+                text_line();
+                if (unit(rng) < opt.multiline_ratio) text_line();
+            }
+            for (const auto& line : text) {
+                out += line;
+                eol();
+            }
+            prev_text.swap(text);
+        }
+        eol();
+    }
+    return out;
+}
+
+bool parse_gen_option(GenOptions& opt, int argc, char** argv, int& i) {
+    const std::string a = argv[i];
+    auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+    if (a == "--cues") opt.cues = (size_t)std::strtoull(next(), nullptr, 10);
+    else if (a == "--eol") {
+        std::string e = next();
+        opt.eol = e == "lf" ? Eol::Lf : e == "cr" ? Eol::Cr : e == "mixed" ? Eol::Mixed : Eol::Crlf;
+    }
+    else if (a == "--multiline") opt.multiline_ratio = std::atof(next());
+    else if (a == "--bom") opt.bom = true;
+    else if (a == "--no-bom") opt.bom = false;
+    else if (a == "--malformed") opt.malformed_rate = std::atof(next());
+    else if (a == "--overlap") opt.overlap_rate = std::atof(next());
+    else if (a == "--repeat-rate") opt.repeat_rate = std::atof(next());
+    else if (a == "--short") opt.short_rate = std::atof(next());
+    else if (a == "--seed") opt.seed = (uint32_t)std::strtoul(next(), nullptr, 10);
+    else return false;
+    return true;
+}
+
+std::string to_utf16le(const std::string& data) {
+    std::string out = "\xFF\xFE";
+    out.reserve(data.size() * 2 + 2);
+    auto put = [&](uint32_t u) {
+        out.push_back((char)(u & 0xFF));
+        out.push_back((char)(u >> 8));
+    };
+    size_t i = 0;
+    if (data.compare(0, 3, "\xEF\xBB\xBF") == 0) i = 3;
+    while (i < data.size()) {
+        const unsigned char c = (unsigned char)data[i];
+        const size_t len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        uint32_t cp = len == 1 ? c : c & (0xFF >> (len + 1));
+        for (size_t k = 1; k < len && i + k < data.size(); ++k) cp = (cp << 6) | ((unsigned char)data[i + k] & 0x3F);
+        i += len;
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            put(0xD800 + (cp >> 10));
+            put(0xDC00 + (cp & 0x3FF));
+        } else {
+            put(cp);
+        }
+    }
+    return out;
+}
+
+std::filesystem::path write_temp_srt(const std::string& data, const std::string& tag) {
+    const auto path = std::filesystem::temp_directory_path() / ("srt_bench_" + tag + ".srt");
+    if (FILE* fp = std::fopen(path.string().c_str(), "wb")) {
+        std::fwrite(data.data(), 1, data.size(), fp);
+        std::fclose(fp);
+    }
+    return path;
+}
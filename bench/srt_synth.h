@@ -0,0 +1,38 @@
+#pragma once
+
+// ベンチマーク用の合成 SRT 生成
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+enum class Eol { Lf, Crlf, Cr, Mixed };
+
+struct GenOptions {
+    size_t cues = 100000;
+    Eol eol = Eol::Crlf;
+    double multiline_ratio = 0.3; // 2行以上の本文を持つキューの割合
+    bool bom = true;
+    double malformed_rate = 0.01; // 壊れたブロックの割合
+    double overlap_rate = 0.0;    // 直前のキューと時間が重なるキューの割合
+    double repeat_rate = 0.0;     // 直前のキューと同じ本文で、直後に続くキューの割合 (音声認識の出力に多い)
+    double short_rate = 0.0;      // 1フレームに満たない (30ms 以下の) キューの割合
+    uint32_t seed = 1;
+};
+
+const char* eol_name(Eol e);
+std::string generate_srt(const GenOptions& opt);
+
+// argv[i] が生成オプション (--cues --eol --multiline --bom --no-bom --malformed --overlap --repeat-rate --short --seed) なら解釈して true を返す。
+// 値を取るオプションは i を値の位置まで進める。
+bool parse_gen_option(GenOptions& opt, int argc, char** argv, int& i);
+
+// 生成オプションの使い方 (usage 表示用)
+extern const char kGenOptionsUsage[];
+
+// UTF-8 の data を UTF-16LE (BOM 付き) に変換する (文字コード変換の計測用。data は妥当な UTF-8 とする)
+std::string to_utf16le(const std::string& data);
+
+// 一時ディレクトリに書き出してパスを返す
+std::filesystem::path write_temp_srt(const std::string& data, const std::string& tag);
@@ -0,0 +1,101 @@
+#include "import_metrics.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+
+static const char* const kPhaseNames[ImportMetrics::PhaseCount] = {
+    "read", "normalize", "parse", "index", "hash", "cache_load", "cache_store", "retime", "alias", "frames", "coalesce", "layers", "create",
+    "set_text", "read_back", "reset", "validate", "move", "delete",
+};
+
+static const char* const kApiNames[ImportMetrics::ApiCount] = {
+    "create_object_from_alias", "set_object_item_value", "get_object_item_value", "move_object",
+};
+
+const char* ImportMetrics::phase_name(Phase phase) {
+    return phase < PhaseCount ? kPhaseNames[phase] : "?";
+}
+
+static std::wstring widen_ascii(const char* s) {
+    std::wstring out;
+    while (*s) out.push_back((wchar_t)(unsigned char)*s++);
+    return out;
+}
+
+//---------------------------------------------------------------------
+// ログ用の要約
+//---------------------------------------------------------------------
+std::wstring format_import_metrics(const ImportMetrics& m) {
+    wchar_t buf[128];
+    std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"SRT import metrics: %llu bytes, %llu cues, %llu objects, %llu sections;",
+        (unsigned long long)m.bytes, (unsigned long long)m.cues, (unsigned long long)m.inserted, (unsigned long long)m.edit_sections);
+    std::wstring out = buf;
+    if (m.cache_hit) out += L" cache hit;";
+    if (m.encoding && std::strcmp(m.encoding, "utf-8") != 0) out += L" converted from " + widen_ascii(m.encoding) + L";";
+    if (m.coalesced) out += L" " + std::to_wstring(m.coalesced) + L" objects saved by coalescing;";
+    for (int i = 0; i < ImportMetrics::PhaseCount; ++i) {
+        if (m.phase_count[i] == 0) continue;
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L" %ls=%.3fms", widen_ascii(kPhaseNames[i]).c_str(), m.phase_ns[i] / 1e6);
+        out += buf;
+        if (m.phase_count[i] > 1) out += L"(x" + std::to_wstring(m.phase_count[i]) + L")";
+    }
+    bool first = true;
+    for (int i = 0; i < ImportMetrics::ApiCount; ++i) {
+        if (m.api_failures[i] == 0) continue;
+        out += first ? L"; failures:" : L",";
+        out += L" " + widen_ascii(kApiNames[i]) + L"=" + std::to_wstring(m.api_failures[i]);
+        first = false;
+    }
+    return out;
+}
+
+//---------------------------------------------------------------------
+// Chrome trace 出力
+//---------------------------------------------------------------------
+std::filesystem::path import_trace_path(const std::filesystem::path& srt_path) {
+    std::filesystem::path out = srt_path;
+    out += ".trace.json";
+    return out;
+}
+
+bool write_import_trace(const ImportMetrics& m, const std::filesystem::path& path) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs) return false;
+
+    char buf[256];
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"prepare\"}},\n";
+    ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"apply\"}}";
+    for (const auto& s : m.spans) {
+        std::snprintf(buf, sizeof(buf), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld",
+            s.name, s.track + 1, (long long)s.begin_us, (long long)(s.end_us - s.begin_us));
+        ofs << buf;
+        if (s.last_cue > s.first_cue) {
+            std::snprintf(buf, sizeof(buf), ",\"args\":{\"first_cue\":%zu,\"last_cue\":%zu}", s.first_cue, s.last_cue);
+            ofs << buf;
+        }
+        ofs << "}";
+    }
+    ofs << "\n],\n\"otherData\":{";
+    std::snprintf(buf, sizeof(buf), "\"bytes\":%llu,\"cues\":%llu,\"coalesced\":%llu,\"objects\":%llu,\"edit_sections\":%llu,\"cache_hit\":%s",
+        (unsigned long long)m.bytes, (unsigned long long)m.cues, (unsigned long long)m.coalesced, (unsigned long long)m.inserted,
+        (unsigned long long)m.edit_sections, m.cache_hit ? "true" : "false");
+    ofs << buf;
+    if (m.encoding) {
+        std::snprintf(buf, sizeof(buf), ",\"encoding\":\"%s\"", m.encoding);
+        ofs << buf;
+    }
+    for (int i = 0; i < ImportMetrics::PhaseCount; ++i) {
+        std::snprintf(buf, sizeof(buf), ",\"%s_ms\":%.3f,\"%s_count\":%llu",
+            kPhaseNames[i], m.phase_ns[i] / 1e6, kPhaseNames[i], (unsigned long long)m.phase_count[i]);
+        ofs << buf;
+    }
+    for (int i = 0; i < ImportMetrics::ApiCount; ++i) {
+        std::snprintf(buf, sizeof(buf), ",\"%s_failures\":%llu", kApiNames[i], (unsigned long long)m.api_failures[i]);
+        ofs << buf;
+    }
+    ofs << "}}\n";
+    return (bool)ofs;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+// インポート1回分の計測 (段階ごとの所要時間・回数、ホストAPIの失敗数、処理量)
+// 結果はログへの要約と、任意で Chrome trace 形式 (chrome://tracing / Perfetto) の JSON として出力する。
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct ImportMetrics {
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase {
+        PhaseRead,       // ファイルを開いてマップ (読み込み) する
+        PhaseNormalize,  // 文字コードの判定と UTF-8 への変換 (BOM 除去を含む)
+        PhaseParse,      // キューのパース (行末・本文の正規化を含む)
+        PhaseIndex,      // 時刻範囲の読み込み: シーク索引の作成・読み込み・保存
+        PhaseHash,       // キャッシュキー用の内容ハッシュ
+        PhaseCacheLoad,  // パースキャッシュの読み込み
+        PhaseCacheStore, // パースキャッシュの書き込み
+        PhaseRetime,     // 時刻の変換 (ずらす・伸縮・2点同期)
+        PhaseAlias,      // alias の組み立て
+        PhaseFrames,     // 時刻→フレーム変換
+        PhaseCoalesce,   // 連続キューの結合
+        PhaseLayers,     // 重なるキューのレイヤー割り当て
+        PhaseCreate,     // create_object_from_alias
+        PhaseSetText,    // 本文の設定
+        PhaseReadBack,   // 本文の読み戻し (改行の確認)
+        PhaseReset,      // \n 形式での再設定
+        PhaseValidate,   // 差分更新: 前回のオブジェクトの確認 (find_object)
+        PhaseMove,       // 差分更新: move_object
+        PhaseDelete,     // 差分更新: delete_object
+        PhaseCount,
+    };
+
+    // 失敗を数えるホストAPI
+    enum HostApi {
+        ApiCreateObject,
+        ApiSetItemValue,
+        ApiGetItemValue,
+        ApiMoveObject,
+        ApiCount,
+    };
+
+    // トレースに出す区間 (origin からのマイクロ秒)
+    struct Span {
+        const char* name;
+        int track; // 0: 準備 (ワーカースレッド), 1: 反映 (編集セクション)
+        int64_t begin_us;
+        int64_t end_us;
+        size_t first_cue; // 反映区間のみ
+        size_t last_cue;
+    };
+
+    Clock::time_point origin = Clock::now();
+    int64_t phase_ns[PhaseCount] = {};
+    uint64_t phase_count[PhaseCount] = {};
+    uint64_t api_failures[ApiCount] = {};
+    uint64_t bytes = 0;
+    uint64_t cues = 0;
+    uint64_t coalesced = 0; // 結合・削除で減らしたオブジェクト数
+    uint64_t inserted = 0;
+    uint64_t edit_sections = 0;
+    bool cache_hit = false;
+    const char* encoding = nullptr; // 判定した入力の文字コード (キャッシュヒット時は判定しないため nullptr)
+    std::vector<Span> spans;
+
+    static const char* phase_name(Phase phase);
+
+    int64_t since_origin_us(Clock::time_point t) const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t - origin).count();
+    }
+
+    // 1回分の所要時間を積算する
+    void add(Phase phase, Clock::time_point begin, Clock::time_point end) {
+        phase_ns[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        ++phase_count[phase];
+    }
+
+    // 準備段階の1区間を積算し、トレースにも残す
+    void add_span(Phase phase, Clock::time_point begin, Clock::time_point end) {
+        add(phase, begin, end);
+        spans.push_back({ phase_name(phase), 0, since_origin_us(begin), since_origin_us(end), 0, 0 });
+    }
+};
+
+// スコープの所要時間を phase に積算する (トレースに残す場合は span = true)
+class PhaseTimer {
+public:
+    PhaseTimer(ImportMetrics& metrics, ImportMetrics::Phase phase, bool span = false)
+        : metrics_(metrics), phase_(phase), span_(span), begin_(ImportMetrics::Clock::now()) {}
+    ~PhaseTimer() {
+        const auto end = ImportMetrics::Clock::now();
+        if (span_) metrics_.add_span(phase_, begin_, end);
+        else metrics_.add(phase_, begin_, end);
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    ImportMetrics& metrics_;
+    ImportMetrics::Phase phase_;
+    bool span_;
+    ImportMetrics::Clock::time_point begin_;
+};
+
+// ログ出力用の1行要約
+std::wstring format_import_metrics(const ImportMetrics& metrics);
+
+// Chrome trace 形式の JSON を書き出す。失敗時は false。
+bool write_import_trace(const ImportMetrics& metrics, const std::filesystem::path& path);
+
+// SRT の隣に置くトレースファイルのパス (<SRT名>.trace.json)
+std::filesystem::path import_trace_path(const std::filesystem::path& srt_path);
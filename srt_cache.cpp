@@ -0,0 +1,376 @@
+#include "srt_cache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+//---------------------------------------------------------------------
+// 内容ハッシュ (xxHash64 と同じ構成の4レーン)
+//---------------------------------------------------------------------
+static constexpr uint64_t kPrime1 = 11400714785074694791ull;
+static constexpr uint64_t kPrime2 = 14029467366897019727ull;
+static constexpr uint64_t kPrime3 = 1609587929392839161ull;
+static constexpr uint64_t kPrime4 = 9650029242287828579ull;
+static constexpr uint64_t kPrime5 = 2870177450012600261ull;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t load64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline uint64_t hash_merge(uint64_t h, uint64_t lane) {
+    h ^= hash_round(0, lane);
+    return h * kPrime1 + kPrime4;
+}
+
+uint64_t srt_content_hash(std::string_view data) {
+    const char* p = data.data();
+    const size_t n = data.size();
+    size_t i = 0;
+    uint64_t h;
+    if (n >= 32) {
+        uint64_t v1 = kPrime1 + kPrime2, v2 = kPrime2, v3 = 0, v4 = 0 - kPrime1;
+        for (; i + 32 <= n; i += 32) {
+            v1 = hash_round(v1, load64(p + i));
+            v2 = hash_round(v2, load64(p + i + 8));
+            v3 = hash_round(v3, load64(p + i + 16));
+            v4 = hash_round(v4, load64(p + i + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    } else {
+        h = kPrime5;
+    }
+    h += (uint64_t)n;
+    for (; i + 8 <= n; i += 8) {
+        h ^= hash_round(0, load64(p + i));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+    }
+    for (; i < n; ++i) {
+        h ^= (uint64_t)(unsigned char)p[i] * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+//---------------------------------------------------------------------
+// キー / 置き場
+//---------------------------------------------------------------------
+bool make_srt_cache_key(const fs::path& path, std::string_view data, SrtCacheKey& key) {
+    std::error_code ec;
+    fs::path abs = fs::absolute(path, ec);
+    if (ec) return false;
+    abs = abs.lexically_normal();
+    const auto size = fs::file_size(abs, ec);
+    if (ec) return false;
+    const auto mtime = fs::last_write_time(abs, ec);
+    if (ec) return false;
+
+    const std::u8string u8 = abs.u8string();
+    key.path.assign(u8.begin(), u8.end());
+    key.size = size;
+    key.mtime = (int64_t)mtime.time_since_epoch().count();
+    key.content_hash = srt_content_hash(data);
+    return true;
+}
+
+fs::path default_srt_cache_dir() {
+    std::error_code ec;
+#ifdef _WIN32
+    if (const wchar_t* local = _wgetenv(L"LOCALAPPDATA")) {
+        if (*local) return fs::path(local) / L"SrtImporter" / L"cache";
+    }
+    return fs::temp_directory_path(ec) / L"SrtImporter" / L"cache";
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg) return fs::path(xdg) / "srtimporter";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        if (*home) return fs::path(home) / ".cache" / "srtimporter";
+    }
+    return fs::temp_directory_path(ec) / "srtimporter";
+#endif
+}
+
+//---------------------------------------------------------------------
+// キャッシュファイル
+//---------------------------------------------------------------------
+// 形式 (リトルエンディアン):
+//   CacheHeader, パス (path_length バイト), 種類ごとのペイロード
+//   パース結果 (.srtc):
+//     start_ms[cue_count] (int64), end_ms[cue_count] (int64), text_length[cue_count] (uint32),
+//     本文アリーナ (arena_size バイト。各本文は NUL 終端で順に並ぶ)
+//   シーク索引 (.srti): cue_count はブロック数、arena_size は 0
+//     block_offset[cue_count + 1] (uint64), prefix_max_end[cue_count] (int64), suffix_min_start[cue_count] (int64)
+// payload_hash はパス以降の全体のハッシュ。途中で切れたファイルや壊れたファイルは使わない。
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t content_hash;
+    uint64_t cue_count;
+    uint64_t arena_size;
+    uint64_t payload_hash;
+    uint32_t path_length;
+    uint32_t reserved;
+};
+static constexpr char kCacheMagic[4] = { 'S', 'R', 'T', 'C' };
+static constexpr char kIndexMagic[4] = { 'S', 'R', 'T', 'I' };
+static constexpr uint32_t kCacheVersion = 1;
+static constexpr const char* kCacheExtension = ".srtc";
+static constexpr const char* kIndexExtension = ".srti";
+
+fs::path SrtParseCache::entry_path(const SrtCacheKey& key, const char* extension) const {
+    static const char kHex[] = "0123456789abcdef";
+    const uint64_t h = srt_content_hash(key.path);
+    std::string name(16, '0');
+    for (int i = 0; i < 16; ++i) name[i] = kHex[(h >> (60 - i * 4)) & 0xF];
+    return dir_ / (name + extension);
+}
+
+// entry を開いてヘッダとキーを確かめ、パスの後ろのペイロードを返す。in は payload を使い終えるまで開いておくこと。
+static bool read_entry(const fs::path& entry, const char (&magic)[4], const SrtCacheKey& key, SrtInputFile& in, CacheHeader& hdr, std::string_view& payload) {
+    std::error_code ec;
+    if (!fs::exists(entry, ec)) return false;
+    if (!in.open(entry)) return false;
+    std::string_view bytes = in.bytes();
+    if (bytes.size() < sizeof(hdr)) return false;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, magic, sizeof(magic)) != 0 || hdr.version != kCacheVersion) return false;
+    if (hdr.source_size != key.size || hdr.source_mtime != key.mtime || hdr.content_hash != key.content_hash) return false;
+
+    const std::string_view rest = bytes.substr(sizeof(hdr));
+    if (rest.size() < hdr.path_length) return false;
+    if (srt_content_hash(rest) != hdr.payload_hash) return false;
+    if (rest.substr(0, hdr.path_length) != key.path) return false;
+    payload = rest.substr(hdr.path_length);
+    return true;
+}
+
+// key のヘッダを付けて entry に書き出す。payload はパスを含めたもの。
+// 書きかけのファイルを読まないよう、一時ファイルに書いてから置き換える。
+static bool write_entry(const fs::path& entry, const char (&magic)[4], const SrtCacheKey& key, CacheHeader hdr, const std::string& payload) {
+    std::memcpy(hdr.magic, magic, sizeof(magic));
+    hdr.version = kCacheVersion;
+    hdr.source_size = key.size;
+    hdr.source_mtime = key.mtime;
+    hdr.content_hash = key.content_hash;
+    hdr.payload_hash = srt_content_hash(payload);
+    hdr.path_length = (uint32_t)key.path.size();
+
+    std::error_code ec;
+    fs::path tmp = entry;
+    tmp += ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs) return false;
+        ofs.write((const char*)&hdr, sizeof(hdr));
+        ofs.write(payload.data(), (std::streamsize)payload.size());
+        if (!ofs) {
+            ofs.close();
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp, entry, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// 最終使用時刻として更新時刻を使う (LRU)
+static void touch_entry(const fs::path& entry) {
+    std::error_code ec;
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+}
+
+bool SrtParseCache::load(const SrtCacheKey& key, SrtCues& cues) const {
+    const fs::path entry = entry_path(key, kCacheExtension);
+    SrtInputFile in;
+    CacheHeader hdr;
+    std::string_view payload;
+    if (!read_entry(entry, kCacheMagic, key, in, hdr, payload)) return false;
+
+    const uint64_t n = hdr.cue_count;
+    if (n > payload.size() / (sizeof(int64_t) * 2 + sizeof(uint32_t))) return false;
+    if (payload.size() != n * (sizeof(int64_t) * 2 + sizeof(uint32_t)) + hdr.arena_size) return false;
+
+    // 配列をそのまま複写し、本文の位置は長さから復元する
+    const char* p = payload.data();
+    SrtCues out;
+    out.start_ms.resize(n);
+    out.end_ms.resize(n);
+    out.text_length.resize(n);
+    std::memcpy(out.start_ms.data(), p, n * sizeof(int64_t));
+    p += n * sizeof(int64_t);
+    std::memcpy(out.end_ms.data(), p, n * sizeof(int64_t));
+    p += n * sizeof(int64_t);
+    std::memcpy(out.text_length.data(), p, n * sizeof(uint32_t));
+    p += n * sizeof(uint32_t);
+    out.arena.assign(p, hdr.arena_size);
+
+    out.text_offset.resize(n);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+        out.text_offset[i] = offset;
+        offset += (size_t)out.text_length[i];
+        if (offset >= out.arena.size() || out.arena[offset] != '\0') return false;
+        ++offset;
+    }
+    if (offset != out.arena.size()) return false;
+
+    in.close();
+    cues = std::move(out);
+    touch_entry(entry);
+    return true;
+}
+
+bool SrtParseCache::store(const SrtCacheKey& key, const SrtCues& cues) const {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) return false;
+
+    const size_t n = cues.size();
+    // 本文は NUL 区切りで隙間なく並んでいればアリーナをそのまま書き、そうでなければ詰め直す
+    bool packed = true;
+    size_t offset = 0;
+    for (size_t i = 0; i < n && packed; ++i) {
+        packed = cues.text_offset[i] == offset;
+        offset += (size_t)cues.text_length[i] + 1;
+    }
+    packed = packed && offset == cues.arena.size();
+
+    std::string payload;
+    payload.reserve(key.path.size() + n * (sizeof(int64_t) * 2 + sizeof(uint32_t)) + cues.arena.size());
+    payload += key.path;
+    payload.append((const char*)cues.start_ms.data(), n * sizeof(int64_t));
+    payload.append((const char*)cues.end_ms.data(), n * sizeof(int64_t));
+    payload.append((const char*)cues.text_length.data(), n * sizeof(uint32_t));
+    const size_t arena_begin = payload.size();
+    if (packed) {
+        payload += cues.arena;
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            payload += cues.text(i);
+            payload += '\0';
+        }
+    }
+
+    CacheHeader hdr{};
+    hdr.cue_count = n;
+    hdr.arena_size = payload.size() - arena_begin;
+    const fs::path entry = entry_path(key, kCacheExtension);
+    if (!write_entry(entry, kCacheMagic, key, hdr, payload)) return false;
+    evict(entry);
+    return true;
+}
+
+bool SrtParseCache::load_index(const SrtCacheKey& key, SrtSeekIndex& index) const {
+    const fs::path entry = entry_path(key, kIndexExtension);
+    SrtInputFile in;
+    CacheHeader hdr;
+    std::string_view payload;
+    if (!read_entry(entry, kIndexMagic, key, in, hdr, payload)) return false;
+
+    const uint64_t n = hdr.cue_count;
+    if (n == 0 || n > payload.size() / (sizeof(uint64_t) + sizeof(int64_t) * 2)) return false;
+    if (payload.size() != (n + 1) * sizeof(uint64_t) + n * sizeof(int64_t) * 2) return false;
+
+    const char* p = payload.data();
+    SrtSeekIndex out;
+    out.block_offset.resize(n + 1);
+    out.prefix_max_end.resize(n);
+    out.suffix_min_start.resize(n);
+    std::memcpy(out.block_offset.data(), p, (n + 1) * sizeof(uint64_t));
+    p += (n + 1) * sizeof(uint64_t);
+    std::memcpy(out.prefix_max_end.data(), p, n * sizeof(int64_t));
+    p += n * sizeof(int64_t);
+    std::memcpy(out.suffix_min_start.data(), p, n * sizeof(int64_t));
+    if (out.block_offset.front() != 0 || out.block_offset.back() > key.size) return false;
+
+    in.close();
+    index = std::move(out);
+    touch_entry(entry);
+    return true;
+}
+
+bool SrtParseCache::store_index(const SrtCacheKey& key, const SrtSeekIndex& index) const {
+    if (index.empty()) return false;
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) return false;
+
+    const size_t n = index.blocks();
+    std::string payload;
+    payload.reserve(key.path.size() + (n + 1) * sizeof(uint64_t) + n * sizeof(int64_t) * 2);
+    payload += key.path;
+    payload.append((const char*)index.block_offset.data(), (n + 1) * sizeof(uint64_t));
+    payload.append((const char*)index.prefix_max_end.data(), n * sizeof(int64_t));
+    payload.append((const char*)index.suffix_min_start.data(), n * sizeof(int64_t));
+
+    CacheHeader hdr{};
+    hdr.cue_count = n;
+    const fs::path entry = entry_path(key, kIndexExtension);
+    if (!write_entry(entry, kIndexMagic, key, hdr, payload)) return false;
+    evict(entry);
+    return true;
+}
+
+// 合計サイズが上限を超えていれば、最終使用 (更新時刻) が古いものから削除する。keep は残す。
+void SrtParseCache::evict(const fs::path& keep) const {
+    struct Entry {
+        fs::file_time_type time;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path ext = it->path().extension();
+        if (ext != kCacheExtension && ext != kIndexExtension) continue;
+        std::error_code e;
+        const uint64_t size = it->file_size(e);
+        if (e) continue;
+        const auto time = it->last_write_time(e);
+        if (e) continue;
+        entries.push_back({ time, size, it->path() });
+        total += size;
+    }
+    if (total <= max_bytes_) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const auto& e : entries) {
+        if (total <= max_bytes_) break;
+        if (e.path == keep) continue;
+        std::error_code rm;
+        if (fs::remove(e.path, rm)) total -= e.size;
+    }
+}
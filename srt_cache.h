@@ -0,0 +1,59 @@
+#pragma once
+
+// パース結果のディスクキャッシュ
+// 同じSRTを設定 (フォント・色など) だけ変えて再インポートする場合に、パースを省く。
+// 時刻はミリ秒のまま保存する (プロジェクトのレート/スケールが変わっても使える)。本文は正規化済みのものを保存する。
+// キーはパス・ファイルサイズ・最終更新時刻・内容のハッシュ。いずれかが変われば使わない。
+// 時刻範囲の読み込み用に、シーク索引 (SrtSeekIndex) も同じキーで別ファイルに保存できる。
+// キャッシュ全体の大きさは上限を超えたら最終使用が古いものから削除する (LRU)。
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "srt_core.h"
+
+// SRT 1ファイル分のキャッシュキー
+struct SrtCacheKey {
+    std::string path; // 絶対パス (UTF-8)
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t content_hash = 0;
+};
+
+// 内容の64bitハッシュ (改ざん検出用ではなく、変更検出用)
+uint64_t srt_content_hash(std::string_view data);
+
+// path とその内容 (data) からキーを作る。ファイル情報が取れなければ false。
+bool make_srt_cache_key(const std::filesystem::path& path, std::string_view data, SrtCacheKey& key);
+
+// 既定のキャッシュ置き場 (Windows: %LOCALAPPDATA%\SrtImporter\cache, それ以外: $XDG_CACHE_HOME/srtimporter)
+std::filesystem::path default_srt_cache_dir();
+
+class SrtParseCache {
+public:
+    static constexpr uint64_t kDefaultMaxBytes = 256ull << 20;
+
+    explicit SrtParseCache(std::filesystem::path dir, uint64_t max_bytes = kDefaultMaxBytes)
+        : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+
+    // key と一致するキャッシュがあれば cues に読み込んで true を返す (最終使用時刻も更新する)
+    bool load(const SrtCacheKey& key, SrtCues& cues) const;
+
+    // cues を保存し、上限を超えていれば古いものから削除する。時刻は start_ms/end_ms のみ保存する。
+    bool store(const SrtCacheKey& key, const SrtCues& cues) const;
+
+    // シーク索引の読み込み / 保存 (パース結果とは別のファイル)
+    bool load_index(const SrtCacheKey& key, SrtSeekIndex& index) const;
+    bool store_index(const SrtCacheKey& key, const SrtSeekIndex& index) const;
+
+    const std::filesystem::path& dir() const { return dir_; }
+
+private:
+    std::filesystem::path entry_path(const SrtCacheKey& key, const char* extension) const;
+    void evict(const std::filesystem::path& keep) const;
+
+    std::filesystem::path dir_;
+    uint64_t max_bytes_;
+};
@@ -0,0 +1,1549 @@
+#include "srt_core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && defined(SRT_HAVE_ICONV)
+#include <cerrno>
+#include <iconv.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && defined(__SSE2__))
+#define SRT_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SRT_TARGET_AVX2
+#else
+#define SRT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define SRT_SCAN_X86 0
+#endif
+
+//---------------------------------------------------------------------
+// SRT入力 (読み取り専用ビュー)
+//---------------------------------------------------------------------
+bool SrtInputFile::open(const std::filesystem::path& path) {
+    close();
+    uint64_t size = 0;
+    switch (map_file(path, size)) {
+    case MapResult::Mapped:
+        return true;
+    case MapResult::Empty:
+        view_ = {};
+        return true;
+    case MapResult::Unreadable:
+        return false;
+    case MapResult::Failed:
+        break;
+    }
+    return read_chunked(path, size);
+}
+
+bool SrtInputFile::map(const std::filesystem::path& path) {
+    close();
+    uint64_t size = 0;
+    switch (map_file(path, size)) {
+    case MapResult::Mapped:
+        return true;
+    case MapResult::Empty:
+        view_ = {};
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SrtInputFile::close() {
+    if (map_base_) {
+#ifdef _WIN32
+        UnmapViewOfFile(map_base_);
+#else
+        munmap(map_base_, (size_t)map_size_);
+#endif
+    }
+    map_base_ = nullptr;
+    map_size_ = 0;
+    view_ = {};
+    fallback_.clear();
+    fallback_.shrink_to_fit();
+}
+
+SrtInputFile::MapResult SrtInputFile::map_file(const std::filesystem::path& path, uint64_t& size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return MapResult::Unreadable;
+    LARGE_INTEGER li{};
+    if (!GetFileSizeEx(file, &li) || li.QuadPart < 0) {
+        CloseHandle(file);
+        return MapResult::Failed;
+    }
+    size = (uint64_t)li.QuadPart;
+    if (size == 0) {
+        CloseHandle(file);
+        return MapResult::Empty;
+    }
+    if (size > (uint64_t)SIZE_MAX) {
+        CloseHandle(file);
+        return MapResult::Unreadable;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    // ビューが生きている間はマッピング/ファイルのハンドルを閉じても参照は保持される
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    if (!base) return MapResult::Failed;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return MapResult::Unreadable;
+    struct stat st{};
+    // パイプなど通常のファイルでないものは大きさが分からずマップもできないため、読み込みで代替する
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return MapResult::Failed;
+    }
+    size = (uint64_t)st.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return MapResult::Empty;
+    }
+    if (size > (uint64_t)SIZE_MAX) {
+        ::close(fd);
+        return MapResult::Unreadable;
+    }
+    void* base = mmap(nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return MapResult::Failed;
+    madvise(base, (size_t)size, MADV_SEQUENTIAL);
+#endif
+    map_base_ = base;
+    map_size_ = size;
+    view_ = std::string_view((const char*)base, (size_t)size);
+    return MapResult::Mapped;
+}
+
+bool SrtInputFile::read_chunked(const std::filesystem::path& path, uint64_t size_hint) {
+    // wfstream がパス非対応の環境があるため、_wfopen で読み込む
+#ifdef _WIN32
+    FILE* fp = _wfopen(path.c_str(), L"rb");
+#else
+    FILE* fp = fopen(path.c_str(), "rb");
+#endif
+    if (!fp) return false;
+    if (size_hint > 0 && size_hint <= (uint64_t)SIZE_MAX) fallback_.reserve((size_t)size_hint);
+    for (;;) {
+        size_t old = fallback_.size();
+        fallback_.resize(old + kReadChunk);
+        size_t got = fread(&fallback_[old], 1, kReadChunk, fp);
+        fallback_.resize(old + got);
+        if (got < kReadChunk) break;
+    }
+    bool ok = !ferror(fp);
+    fclose(fp);
+    if (!ok) {
+        fallback_.clear();
+        return false;
+    }
+    view_ = fallback_;
+    return true;
+}
+
+//---------------------------------------------------------------------
+// 行/キュー境界のベクトル化走査 (SSE2 / AVX2、実行時に選択。非x86はスカラー)
+//---------------------------------------------------------------------
+namespace srt_scan {
+
+static inline bool is_space_byte(unsigned char c) {
+    // std::isspace ("C" ロケール) と同じ集合: ' ', \t, \n, \v, \f, \r
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static size_t find_line_break_scalar(const char* p, size_t n, size_t i = 0) {
+    while (i < n && p[i] != '\n' && p[i] != '\r') ++i;
+    return i;
+}
+
+static size_t find_arrow_scalar(const char* p, size_t n, size_t i = 0) {
+    for (; i + 3 <= n; ++i) {
+        if (p[i] == '-' && p[i + 1] == '-' && p[i + 2] == '>') return i;
+    }
+    return std::string_view::npos;
+}
+
+static bool all_space_scalar(const char* p, size_t n, size_t i = 0) {
+    for (; i < n; ++i) {
+        if (!is_space_byte((unsigned char)p[i])) return false;
+    }
+    return true;
+}
+
+// p[i] から始まる UTF-8 の1文字の長さ。不正なら 0。
+// 冗長表現・サロゲート・U+10FFFF 超・途中で切れた文字はすべて不正とする。
+static inline size_t utf8_char_len(const unsigned char* p, size_t n, size_t i) {
+    const unsigned c = p[i];
+    if (c < 0x80) return 1;
+    size_t len;
+    unsigned lo = 0x80, hi = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        len = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        len = 3;
+        if (c == 0xE0) lo = 0xA0;
+        else if (c == 0xED) hi = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        len = 4;
+        if (c == 0xF0) lo = 0x90;
+        else if (c == 0xF4) hi = 0x8F;
+    } else {
+        return 0;
+    }
+    if (n - i < len || p[i + 1] < lo || p[i + 1] > hi) return 0;
+    for (size_t k = 2; k < len; ++k) {
+        if ((p[i + k] & 0xC0) != 0x80) return 0;
+    }
+    return len;
+}
+
+static bool valid_utf8_scalar(const char* s, size_t n, size_t i = 0) {
+    const unsigned char* p = (const unsigned char*)s;
+    while (i < n) {
+        size_t len = utf8_char_len(p, n, i);
+        if (len == 0) return false;
+        i += len;
+    }
+    return true;
+}
+
+// 時刻の一次変換 (apply_timing_transform)。
+// 0 <= t < 2^52 の整数は、2^52 の指数ビットを OR して 2^52 を引けば double に正確に変換でき、
+// 逆に 2^52 を足せば最も近い整数に丸めた上で仮数部から取り出せる。整数⇔浮動小数の変換命令を使わないため、
+// 64bit 整数の変換命令が無い SSE2 / AVX2 でも1命令ずつのベクトル演算だけで済む。
+// そのため変換後の値は [0, kRetimeMaxMs] に収める。丸めて 0 以下になった終了は 0 のままにしておき、呼び出し側で取り除く。
+constexpr uint64_t kRetimeBiasBits = 0x4330000000000000ull; // 2^52 の double 表現
+constexpr double kRetimeBias = 4503599627370496.0;          // 2^52
+constexpr double kRetimeMaxMs = kRetimeBias - 2;             // 終了 = 開始 + 1 でも 2^52 未満に収まるように
+
+static inline double retime_biased(int64_t t, double scale, double offset) {
+    const double v = std::bit_cast<double>((uint64_t)t | kRetimeBiasBits) - kRetimeBias;
+    return std::min(std::max(v * scale + offset, 0.0), kRetimeMaxMs) + kRetimeBias;
+}
+
+static void retime_scalar(int64_t* start, int64_t* end, size_t n, double scale, double offset, size_t i = 0) {
+    for (; i < n; ++i) {
+        const double s = retime_biased(start[i], scale, offset);
+        double e = retime_biased(end[i], scale, offset);
+        if (e > kRetimeBias) e = std::max(e, s + 1.0); // 終了が 0 以下のキューは 0 のまま残し、後で取り除く
+        start[i] = (int64_t)(std::bit_cast<uint64_t>(s) ^ kRetimeBiasBits);
+        end[i] = (int64_t)(std::bit_cast<uint64_t>(e) ^ kRetimeBiasBits);
+    }
+}
+
+#if SRT_SCAN_X86
+static inline unsigned first_bit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// SSE2 (x86-64 では常に利用可能)
+static size_t find_line_break_sse2(const char* p, size_t n) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+        if (m) return i + first_bit(m);
+    }
+    return find_line_break_scalar(p, n, i);
+}
+
+static size_t find_arrow_sse2(const char* p, size_t n) {
+    const __m128i dash = _mm_set1_epi8('-');
+    const __m128i gt = _mm_set1_epi8('>');
+    size_t i = 0;
+    for (; i + 18 <= n; i += 16) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), dash);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 1)), dash);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 2)), gt);
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), c));
+        if (m) return i + first_bit(m);
+    }
+    return find_arrow_scalar(p, n, i);
+}
+
+static bool all_space_sse2(const char* p, size_t n) {
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i range = _mm_set1_epi8('\r' - '\t');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        // (v - '\t') <= 4 (符号なし) で \t..\r を判定
+        __m128i d = _mm_sub_epi8(v, tab);
+        __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(d, range), d);
+        __m128i ws = _mm_or_si128(ctl, _mm_cmpeq_epi8(v, sp));
+        if (_mm_movemask_epi8(ws) != 0xFFFF) return false;
+    }
+    return all_space_scalar(p, n, i);
+}
+
+// ASCII だけの16バイトは読み飛ばし、非ASCIIを含む箇所だけ1文字ずつ検証する
+static bool valid_utf8_sse2(const char* s, size_t n) {
+    const unsigned char* p = (const unsigned char*)s;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i)));
+        if (m == 0) {
+            i += 16;
+            continue;
+        }
+        i += first_bit(m);
+        size_t len = utf8_char_len(p, n, i);
+        if (len == 0) return false;
+        i += len;
+    }
+    return valid_utf8_scalar(s, n, i);
+}
+
+static void retime_sse2(int64_t* start, int64_t* end, size_t n, double scale, double offset) {
+    const __m128i bits = _mm_set1_epi64x((long long)kRetimeBiasBits);
+    const __m128d bias = _mm_set1_pd(kRetimeBias);
+    const __m128d k = _mm_set1_pd(scale), b = _mm_set1_pd(offset);
+    const __m128d lo = _mm_setzero_pd(), hi = _mm_set1_pd(kRetimeMaxMs), one = _mm_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d s = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_loadu_si128((const __m128i*)(start + i)), bits)), bias);
+        __m128d e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_loadu_si128((const __m128i*)(end + i)), bits)), bias);
+        s = _mm_add_pd(_mm_min_pd(_mm_max_pd(_mm_add_pd(_mm_mul_pd(s, k), b), lo), hi), bias);
+        e = _mm_add_pd(_mm_min_pd(_mm_max_pd(_mm_add_pd(_mm_mul_pd(e, k), b), lo), hi), bias);
+        const __m128d ends_after_zero = _mm_cmpgt_pd(e, bias);
+        e = _mm_or_pd(_mm_and_pd(ends_after_zero, _mm_max_pd(e, _mm_add_pd(s, one))), _mm_andnot_pd(ends_after_zero, e));
+        _mm_storeu_si128((__m128i*)(start + i), _mm_xor_si128(_mm_castpd_si128(s), bits));
+        _mm_storeu_si128((__m128i*)(end + i), _mm_xor_si128(_mm_castpd_si128(e), bits));
+    }
+    retime_scalar(start, end, n, scale, offset, i);
+}
+
+// AVX2 (CPUが対応している場合のみ使用)
+SRT_TARGET_AVX2 static size_t find_line_break_avx2(const char* p, size_t n) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+        if (m) return i + first_bit(m);
+    }
+    size_t rest = find_line_break_sse2(p + i, n - i);
+    return i + rest;
+}
+
+SRT_TARGET_AVX2 static size_t find_arrow_avx2(const char* p, size_t n) {
+    const __m256i dash = _mm256_set1_epi8('-');
+    const __m256i gt = _mm256_set1_epi8('>');
+    size_t i = 0;
+    for (; i + 34 <= n; i += 32) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), dash);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 1)), dash);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 2)), gt);
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(a, b), c));
+        if (m) return i + first_bit(m);
+    }
+    size_t rest = find_arrow_sse2(p + i, n - i);
+    return rest == std::string_view::npos ? rest : i + rest;
+}
+
+SRT_TARGET_AVX2 static bool all_space_avx2(const char* p, size_t n) {
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i range = _mm256_set1_epi8('\r' - '\t');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i d = _mm256_sub_epi8(v, tab);
+        __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(d, range), d);
+        __m256i ws = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, sp));
+        if ((unsigned)_mm256_movemask_epi8(ws) != 0xFFFFFFFFu) return false;
+    }
+    return all_space_sse2(p + i, n - i);
+}
+
+// UTF-8 検証の表引き (Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte")。
+// 直前のバイトの上位/下位4bitと現在のバイトの上位4bitでそれぞれ表を引き、AND が非0なら誤り。
+enum : uint8_t {
+    kUtf8TooShort = 1 << 0,   // 先頭バイトの後に継続バイトが無い
+    kUtf8TooLong = 1 << 1,    // ASCII の後に継続バイト
+    kUtf8Overlong3 = 1 << 2,  // E0 80..9F
+    kUtf8TooLarge = 1 << 3,   // F4 90.. 以上
+    kUtf8Surrogate = 1 << 4,  // ED A0..BF
+    kUtf8Overlong2 = 1 << 5,  // C0 / C1
+    kUtf8TooLarge1000 = 1 << 6, // F5.. 以上
+    kUtf8Overlong4 = 1 << 6,  // F0 80..8F
+    kUtf8TwoConts = 1 << 7,   // 継続バイトが続く (3/4バイト文字の途中でなければ誤り)
+    kUtf8Carry = kUtf8TooShort | kUtf8TooLong | kUtf8TwoConts,
+};
+
+alignas(16) static const uint8_t kUtf8Byte1High[16] = {
+    kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong,
+    kUtf8TwoConts, kUtf8TwoConts, kUtf8TwoConts, kUtf8TwoConts,
+    kUtf8TooShort | kUtf8Overlong2,
+    kUtf8TooShort,
+    kUtf8TooShort | kUtf8Overlong3 | kUtf8Surrogate,
+    kUtf8TooShort | kUtf8TooLarge | kUtf8TooLarge1000 | kUtf8Overlong4,
+};
+alignas(16) static const uint8_t kUtf8Byte1Low[16] = {
+    kUtf8Carry | kUtf8Overlong3 | kUtf8Overlong2 | kUtf8Overlong4,
+    kUtf8Carry | kUtf8Overlong2,
+    kUtf8Carry,
+    kUtf8Carry,
+    kUtf8Carry | kUtf8TooLarge,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000 | kUtf8Surrogate,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+};
+alignas(16) static const uint8_t kUtf8Byte2High[16] = {
+    kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort,
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Overlong3 | kUtf8TooLarge1000 | kUtf8Overlong4,
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Overlong3 | kUtf8TooLarge,
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Surrogate | kUtf8TooLarge,
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Surrogate | kUtf8TooLarge,
+    kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort,
+};
+// 末尾3バイトがこれを超えると、次のブロックに続く文字が途中で切れている
+alignas(32) static const uint8_t kUtf8IncompleteMax[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+// 32バイト分の誤りビット。prev は直前のブロック (先頭なら 0)。
+SRT_TARGET_AVX2 static inline __m256i utf8_block_errors(__m256i input, __m256i prev) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i byte1_high = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)kUtf8Byte1High));
+    const __m256i byte1_low = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)kUtf8Byte1Low));
+    const __m256i byte2_high = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)kUtf8Byte2High));
+    // 1/2/3バイト前のバイト列 (ブロックをまたぐ分は prev の末尾から取る)
+    const __m256i carried = _mm256_permute2x128_si256(prev, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, carried, 15);
+    const __m256i prev2 = _mm256_alignr_epi8(input, carried, 14);
+    const __m256i prev3 = _mm256_alignr_epi8(input, carried, 13);
+
+    __m256i special = _mm256_shuffle_epi8(byte1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    special = _mm256_and_si256(special, _mm256_shuffle_epi8(byte1_low, _mm256_and_si256(prev1, nibble)));
+    special = _mm256_and_si256(special, _mm256_shuffle_epi8(byte2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+    // 3/4バイト文字の3・4バイト目では継続バイトが続くのが正しいため、TwoConts を打ち消す
+    const __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    const __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    const __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+SRT_TARGET_AVX2 static bool valid_utf8_avx2(const char* p, size_t n) {
+    const __m256i incomplete_max = _mm256_load_si256((const __m256i*)kUtf8IncompleteMax);
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i input = _mm256_loadu_si256((const __m256i*)(p + i));
+        if (_mm256_movemask_epi8(input) == 0) {
+            // ASCII だけのブロック: 直前のブロックで文字が切れていなければ検証不要
+            error = _mm256_or_si256(error, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+        } else {
+            error = _mm256_or_si256(error, utf8_block_errors(input, prev));
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        prev = input;
+        if (!_mm256_testz_si256(error, error)) return false;
+    }
+    if (i < n) {
+        // 端数は 0 (ASCII) で埋めて1ブロックとして検証する。切れた文字は TooShort になる。
+        alignas(32) char tail[32] = {};
+        std::memcpy(tail, p + i, n - i);
+        const __m256i input = _mm256_load_si256((const __m256i*)tail);
+        error = _mm256_or_si256(error, utf8_block_errors(input, prev));
+        prev_incomplete = _mm256_setzero_si256();
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+SRT_TARGET_AVX2 static void retime_avx2(int64_t* start, int64_t* end, size_t n, double scale, double offset) {
+    const __m256i bits = _mm256_set1_epi64x((long long)kRetimeBiasBits);
+    const __m256d bias = _mm256_set1_pd(kRetimeBias);
+    const __m256d k = _mm256_set1_pd(scale), b = _mm256_set1_pd(offset);
+    const __m256d lo = _mm256_setzero_pd(), hi = _mm256_set1_pd(kRetimeMaxMs), one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d s = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_loadu_si256((const __m256i*)(start + i)), bits)), bias);
+        __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_loadu_si256((const __m256i*)(end + i)), bits)), bias);
+        s = _mm256_add_pd(_mm256_min_pd(_mm256_max_pd(_mm256_add_pd(_mm256_mul_pd(s, k), b), lo), hi), bias);
+        e = _mm256_add_pd(_mm256_min_pd(_mm256_max_pd(_mm256_add_pd(_mm256_mul_pd(e, k), b), lo), hi), bias);
+        e = _mm256_blendv_pd(e, _mm256_max_pd(e, _mm256_add_pd(s, one)), _mm256_cmp_pd(e, bias, _CMP_GT_OQ));
+        _mm256_storeu_si256((__m256i*)(start + i), _mm256_xor_si256(_mm256_castpd_si256(s), bits));
+        _mm256_storeu_si256((__m256i*)(end + i), _mm256_xor_si256(_mm256_castpd_si256(e), bits));
+    }
+    retime_sse2(start + i, end + i, n - i, scale, offset);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+struct Ops {
+    size_t (*find_line_break)(const char* p, size_t n);
+    size_t (*find_arrow)(const char* p, size_t n);
+    bool (*all_space)(const char* p, size_t n);
+    bool (*valid_utf8)(const char* p, size_t n);
+    void (*retime)(int64_t* start, int64_t* end, size_t n, double scale, double offset);
+};
+
+// 読み込み時に一度だけ選択する
+static const Ops g_ops = [] {
+#if SRT_SCAN_X86
+    if (cpu_has_avx2()) return Ops{ find_line_break_avx2, find_arrow_avx2, all_space_avx2, valid_utf8_avx2, retime_avx2 };
+    return Ops{ find_line_break_sse2, find_arrow_sse2, all_space_sse2, valid_utf8_sse2, retime_sse2 };
+#else
+    return Ops{
+        [](const char* p, size_t n) { return find_line_break_scalar(p, n); },
+        [](const char* p, size_t n) { return find_arrow_scalar(p, n); },
+        [](const char* p, size_t n) { return all_space_scalar(p, n); },
+        [](const char* p, size_t n) { return valid_utf8_scalar(p, n); },
+        [](int64_t* start, int64_t* end, size_t n, double scale, double offset) { retime_scalar(start, end, n, scale, offset); },
+    };
+#endif
+}();
+
+// 最初の '\r' または '\n' の位置 (無ければ s.size())
+static inline size_t find_line_break(std::string_view s) { return g_ops.find_line_break(s.data(), s.size()); }
+// 最初の "-->" の位置 (無ければ npos)
+static inline size_t find_arrow(std::string_view s) { return g_ops.find_arrow(s.data(), s.size()); }
+// 空白文字のみで構成されているか
+static inline bool all_space(std::string_view s) { return g_ops.all_space(s.data(), s.size()); }
+// UTF-8 として妥当か
+static inline bool valid_utf8(std::string_view s) { return g_ops.valid_utf8(s.data(), s.size()); }
+// start[i] / end[i] を t * scale + offset に置き換える (丸め・下限0。終了は開始 + 1 以上だが、0 以下になった終了は 0 のまま)
+static inline void retime(int64_t* start, int64_t* end, size_t n, double scale, double offset) {
+    g_ops.retime(start, end, n, scale, offset);
+}
+
+} // namespace srt_scan
+
+//---------------------------------------------------------------------
+// SRTパース (UTF-8 + CRLF/CR/LF対応。parse_srt / parse_srt_stream は UTF-16 / Shift_JIS を UTF-8 に変換してから渡す)
+//---------------------------------------------------------------------
+// 時刻欄 "HH:MM:SS,mmm" (ミリ秒区切りは "." も可) を整数ミリ秒に変換する。失敗時は -1。
+// 行ビューを直接読み、各数値欄は従来の sscanf("%d") と同じく前置の空白と符号を許容し、
+// ミリ秒以降の文字 (座標指定など) は無視する。ロケールに依存せず、確保も行わない。
+int64_t parse_timestamp_ms(std::string_view s) {
+    size_t i = 0;
+
+    auto read_field = [&](int64_t& value) {
+        while (i < s.size() && srt_scan::is_space_byte((unsigned char)s[i])) ++i;
+        bool negative = false;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+            negative = (s[i] == '-');
+            ++i;
+        }
+        // 桁数を制限してオーバーフローを防ぐ
+        size_t begin = i;
+        value = 0;
+        while (i < s.size() && i - begin < 9 && s[i] >= '0' && s[i] <= '9') {
+            value = value * 10 + (s[i] - '0');
+            ++i;
+        }
+        if (negative) value = -value;
+        return i > begin;
+    };
+    auto expect = [&](char a, char b) {
+        if (i < s.size() && (s[i] == a || s[i] == b)) {
+            ++i;
+            return true;
+        }
+        return false;
+    };
+
+    int64_t hh = 0, mm = 0, ss = 0, ms = 0;
+    if (!read_field(hh) || !expect(':', ':')) return -1;
+    if (!read_field(mm) || !expect(':', ':')) return -1;
+    if (!read_field(ss) || !expect(',', '.')) return -1;
+    if (!read_field(ms)) return -1;
+    return ((hh * 60 + mm) * 60 + ss) * 1000 + ms;
+}
+
+// ミリ秒 → フレーム (切り捨て)。frame = ms * rate / (1000 * scale) を64bit整数で正確に計算する。
+int ms_to_frame(int64_t ms, int rate, int scale) {
+    if (ms <= 0 || rate <= 0 || scale <= 0) return 0;
+    const int64_t den = 1000 * (int64_t)scale;
+    // ms * rate が64bitに収まらない場合は商と余りに分けて計算する
+    int64_t frame = (ms <= INT64_MAX / rate)
+        ? ms * rate / den
+        : (ms / den) * rate + (ms % den) * rate / den;
+    return (int)std::min<int64_t>(frame, INT_MAX);
+}
+
+// 入力バッファ上を1行ずつ進むカーソル。行は string_view で参照するだけでコピーしない。
+// CRLF / CR / LF のいずれも1つの行末として扱う (std::getline と同じく末尾の空行は作らない)。
+struct SrtLineCursor {
+    std::string_view data;
+    size_t next = 0;
+    std::string_view line;
+    bool has_line = false;
+
+    explicit SrtLineCursor(std::string_view d) : data(d) { advance(); }
+
+    void advance() {
+        if (next >= data.size()) {
+            line = {};
+            has_line = false;
+            return;
+        }
+        size_t end = next + srt_scan::find_line_break(data.substr(next));
+        line = data.substr(next, end - next);
+        has_line = true;
+        if (end < data.size()) {
+            end += (data[end] == '\r' && end + 1 < data.size() && data[end + 1] == '\n') ? 2 : 1;
+        }
+        next = end;
+    }
+
+    // 現在行の data 先頭からのオフセット
+    size_t offset() const { return (size_t)(line.data() - data.data()); }
+};
+
+static bool is_blank_line(std::string_view s) {
+    return srt_scan::all_space(s);
+}
+
+// テキスト設定向けに改行を正規化し、out の末尾に追加する。
+// - 実改行(CRLF/CR/LF)は LF に統一
+// - エスケープ改行(\n, \N, \r, \r\n) は実改行(LF)に変換
+// - エスケープされたバックスラッシュ(\\)は維持
+// パーサは本文を1行ずつこの関数でアリーナへ書き込む (エスケープは行をまたがないため、行単位でも結果は同じ)。
+void normalize_text_value(std::string_view s, std::string& out) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '\r') {
+            out.push_back('\n');
+            if (i + 1 < s.size() && s[i + 1] == '\n') ++i;
+            continue;
+        }
+        if (c == '\n') {
+            out.push_back('\n');
+            continue;
+        }
+        if (c == '\\' && i + 1 < s.size()) {
+            char n = s[i + 1];
+            if (n == '\\') {
+                out.push_back('\\');
+                ++i;
+                continue;
+            }
+            if (n == 'n' || n == 'N') {
+                out.push_back('\n');
+                ++i;
+                continue;
+            }
+            if (n == 'r') {
+                out.push_back('\n');
+                ++i;
+                if (i + 2 < s.size() && s[i + 1] == '\\' && (s[i + 2] == 'n' || s[i + 2] == 'N')) {
+                    i += 2; // \r\n 形式をまとめて1改行へ
+                }
+                continue;
+            }
+        }
+        out.push_back(c);
+    }
+}
+
+// 本文の行範囲 raw を正規化して out の末尾に追加する (行は LF で連結する)
+static void append_cue_text(std::string_view raw, std::string& out) {
+    const size_t offset = out.size();
+    for (SrtLineCursor tc(raw); tc.has_line; tc.advance()) {
+        if (out.size() != offset) out += '\n';
+        normalize_text_value(tc.line, out);
+    }
+}
+
+// data を1パスで走査し、有効なキューごとに emit(start_ms, end_ms, raw_text) を呼ぶ (raw_text は正規化前の本文の行範囲)。
+// emit が false を返すと走査をやめる。
+// final が false の場合、data は入力の途中で切れているものとして、空行で閉じていない最後のブロックは emit せず、
+// その先頭位置を返す (続きを読み足してからそこから走査し直す)。それ以外は data.size() を返す。
+template <class Emit>
+static size_t scan_srt_blocks(std::string_view data, bool final, Emit&& emit) {
+    SrtLineCursor cur(data);
+    while (cur.has_line) {
+        // 先頭の空行をスキップ
+        while (cur.has_line && is_blank_line(cur.line)) cur.advance();
+        if (!cur.has_line) break;
+        const size_t block = cur.offset();
+
+        // インデックス行は任意。時刻行でなければ1行だけ読み飛ばして次を時刻行として試す。
+        if (srt_scan::find_arrow(cur.line) == std::string_view::npos) {
+            cur.advance();
+            if (!cur.has_line) return final ? data.size() : block;
+        }
+
+        // 時刻行
+        const std::string_view tl = cur.line;
+        auto arrow = srt_scan::find_arrow(tl);
+        if (arrow == std::string_view::npos) {
+            while (cur.has_line && !is_blank_line(cur.line)) cur.advance();
+            if (!final && !cur.has_line) return block;
+            continue;
+        }
+        int64_t start_ms = parse_timestamp_ms(tl.substr(0, arrow));
+        int64_t end_ms = parse_timestamp_ms(tl.substr(arrow + 3));
+        cur.advance();
+
+        // テキスト行 (複数行字幕に対応)。まず範囲だけ確定し、連結は有効なキューに対してのみ行う。
+        size_t text_begin = cur.has_line ? cur.offset() : data.size();
+        size_t text_end = text_begin;
+        while (cur.has_line && !is_blank_line(cur.line)) {
+            text_end = cur.offset() + cur.line.size();
+            cur.advance();
+        }
+        if (!final && !cur.has_line) return block;
+
+        if (start_ms < 0 || end_ms < 0 || end_ms <= start_ms || text_end == text_begin) {
+            continue;
+        }
+        if (!emit(start_ms, end_ms, data.substr(text_begin, text_end - text_begin))) break;
+    }
+    return data.size();
+}
+
+// data を1パスで走査してキューを out に追加する。本文は正規化しながらアリーナへ直接書き込む。
+// data は行頭から始まり、空行の直前 (またはバッファ末尾) で終わる範囲であればよい。
+static void parse_srt_range(std::string_view data, SrtCues& out) {
+    scan_srt_blocks(data, true, [&](int64_t start_ms, int64_t end_ms, std::string_view raw) {
+        out.start_ms.push_back(start_ms);
+        out.end_ms.push_back(end_ms);
+        const size_t offset = out.arena.size();
+        append_cue_text(raw, out.arena);
+        out.text_offset.push_back(offset);
+        out.text_length.push_back((uint32_t)(out.arena.size() - offset));
+        out.arena += '\0';
+        return true;
+    });
+}
+
+// from 以降で最初に現れる空行の行頭位置を返す (無ければ data.size())。
+// パーサは空行をまたいで状態を持たないため、この位置で分割しても逐次パースと結果は変わらない。
+static size_t find_cue_boundary(std::string_view data, size_t from) {
+    auto next_line_start = [&](size_t pos) -> size_t {
+        size_t br = pos + srt_scan::find_line_break(data.substr(pos));
+        if (br >= data.size()) return data.size();
+        return br + ((data[br] == '\r' && br + 1 < data.size() && data[br + 1] == '\n') ? 2 : 1);
+    };
+
+    if (from == 0) return 0;
+    // from は行の途中 (CRLF の間を含む) の可能性があるため、次の行頭まで進める
+    size_t pos = next_line_start(from);
+    while (pos < data.size()) {
+        size_t br = pos + srt_scan::find_line_break(data.substr(pos));
+        if (is_blank_line(data.substr(pos, br - pos))) return pos;
+        pos = next_line_start(pos);
+    }
+    return data.size();
+}
+
+// 各範囲を別スレッドでパースし、順番どおりに連結する。
+SrtCues parse_srt_parallel(std::string_view data, size_t workers) {
+    std::vector<size_t> bounds{ 0 };
+    for (size_t k = 1; k < workers; ++k) {
+        size_t b = find_cue_boundary(data, std::max(bounds.back(), data.size() / workers * k));
+        if (b >= data.size()) break;
+        if (b > bounds.back()) bounds.push_back(b);
+    }
+    bounds.push_back(data.size());
+
+    const size_t chunks = bounds.size() - 1;
+    std::vector<SrtCues> parts(chunks);
+    std::atomic<bool> failed{ false };
+    auto run = [&](size_t k) {
+        try {
+            parts[k].arena.reserve(bounds[k + 1] - bounds[k] + 1);
+            parse_srt_range(data.substr(bounds[k], bounds[k + 1] - bounds[k]), parts[k]);
+        } catch (...) {
+            failed = true;
+        }
+    };
+    // 先頭の範囲は呼び出しスレッドで処理する。スレッドを作れない場合もその場で処理する。
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for (size_t k = 1; k < chunks; ++k) {
+        try {
+            threads.emplace_back(run, k);
+        } catch (...) {
+            run(k);
+        }
+    }
+    run(0);
+    for (auto& t : threads) t.join();
+    if (failed) return {};
+
+    size_t total = 0, total_text = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+        total_text += part.arena.size();
+    }
+    SrtCues out;
+    out.start_ms.reserve(total);
+    out.end_ms.reserve(total);
+    out.text_offset.reserve(total);
+    out.text_length.reserve(total);
+    out.arena.reserve(total_text);
+    for (auto& part : parts) {
+        out.append(part);
+        part.clear();
+    }
+    return out;
+}
+
+// これ未満のサイズは逐次パースする (スレッド生成の方が高くつくため)
+static constexpr size_t kParallelParseThreshold = 8u << 20;
+// 1スレッドあたりの最小サイズ
+static constexpr size_t kParallelParseMinChunk = 2u << 20;
+
+std::string_view strip_utf8_bom(std::string_view data) {
+    // 簡易UTF-8チェック: BOMがあればスキップ
+    if (data.size() >= 3 && (unsigned char)data[0] == 0xEF && (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF) {
+        data.remove_prefix(3);
+    }
+    return data;
+}
+
+//---------------------------------------------------------------------
+// 文字コードの判定と UTF-8 への変換
+//---------------------------------------------------------------------
+const char* srt_encoding_name(SrtEncoding encoding) {
+    switch (encoding) {
+    case SrtEncoding::Utf8: return "utf-8";
+    case SrtEncoding::Utf16Le: return "utf-16le";
+    case SrtEncoding::Utf16Be: return "utf-16be";
+    case SrtEncoding::ShiftJis: return "shift_jis";
+    }
+    return "?";
+}
+
+// Shift_JIS (CP932) として構造が正しいか。
+// 先頭バイト 81..9F / E0..FC の後に 40..7E / 80..FC が続き、単独バイトは ASCII と半角カナ (A1..DF) のみ。
+static bool looks_like_shift_jis(std::string_view data) {
+    const unsigned char* p = (const unsigned char*)data.data();
+    const size_t n = data.size();
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned c = p[i];
+        if (c < 0x80 || (c >= 0xA1 && c <= 0xDF)) continue;
+        if (!((c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC))) return false;
+        if (++i >= n) return false;
+        const unsigned t = p[i];
+        if (t < 0x40 || t == 0x7F || t > 0xFC) return false;
+    }
+    return true;
+}
+
+SrtEncoding detect_srt_encoding(std::string_view data) {
+    const unsigned char* p = (const unsigned char*)data.data();
+    if (data.size() >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) return SrtEncoding::Utf8;
+    if (data.size() >= 2 && p[0] == 0xFF && p[1] == 0xFE) return SrtEncoding::Utf16Le;
+    if (data.size() >= 2 && p[0] == 0xFE && p[1] == 0xFF) return SrtEncoding::Utf16Be;
+
+    // BOM の無い UTF-16: 番号・時刻行は ASCII なので、上位バイト側に 0 が偏る。
+    // UTF-8 / Shift_JIS の字幕には 0 はまず現れないため、先頭の一部を見るだけで足りる。
+    const size_t sample = std::min<size_t>(data.size(), 4096) & ~(size_t)1;
+    size_t zero_even = 0, zero_odd = 0;
+    for (size_t i = 0; i < sample; i += 2) {
+        zero_even += p[i] == 0;
+        zero_odd += p[i + 1] == 0;
+    }
+    const size_t units = sample / 2;
+    if (units >= 4) {
+        if (zero_odd * 4 >= units && zero_even * 8 <= zero_odd) return SrtEncoding::Utf16Le;
+        if (zero_even * 4 >= units && zero_odd * 8 <= zero_even) return SrtEncoding::Utf16Be;
+    }
+
+    // UTF-8 の判定が通常の経路で、ここで払うのはベクトル化した検証の1回の走査だけ
+    if (srt_scan::valid_utf8(data)) return SrtEncoding::Utf8;
+    if (looks_like_shift_jis(data)) return SrtEncoding::ShiftJis;
+    // どれにも当てはまらなければ従来通り UTF-8 として扱う (不正なバイトはそのまま本文に入る)
+    return SrtEncoding::Utf8;
+}
+
+static inline void append_utf8(std::string& out, uint32_t c) {
+    if (c < 0x80) {
+        out.push_back((char)c);
+    } else if (c < 0x800) {
+        out.push_back((char)(0xC0 | (c >> 6)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        out.push_back((char)(0xE0 | (c >> 12)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    } else {
+        out.push_back((char)(0xF0 | (c >> 18)));
+        out.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    }
+}
+
+// UTF-16 の units 単位を out の末尾に UTF-8 で追加する。対になっていないサロゲートは U+FFFD にする。
+template <class Unit>
+static void append_utf16_as_utf8(Unit unit, size_t units, std::string& out) {
+    for (size_t k = 0; k < units; ++k) {
+        uint32_t c = unit(k);
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            const uint32_t d = (c <= 0xDBFF && k + 1 < units) ? (uint32_t)unit(k + 1) : 0;
+            if (d >= 0xDC00 && d <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (d - 0xDC00);
+                ++k;
+            } else {
+                c = 0xFFFD;
+            }
+        }
+        append_utf8(out, c);
+    }
+}
+
+static void utf16_to_utf8(std::string_view data, bool big_endian, std::string& out, bool skip_bom = true) {
+    const unsigned char* p = (const unsigned char*)data.data();
+    // 奇数バイトの端数は捨てる
+    const size_t units = data.size() / 2;
+    size_t k = 0;
+    auto unit = [&](size_t i) -> uint32_t {
+        const unsigned char* u = p + 2 * i;
+        return big_endian ? (uint32_t)(u[0] << 8 | u[1]) : (uint32_t)(u[1] << 8 | u[0]);
+    };
+    if (skip_bom && units > 0 && unit(0) == 0xFEFF) k = 1;
+    // 字幕は時刻行など ASCII が多いため、出力は入力と同程度の大きさを見込む
+    out.reserve(out.size() + units + units / 2);
+    append_utf16_as_utf8([&](size_t i) { return unit(k + i); }, units - k, out);
+}
+
+// Shift_JIS (CP932) → UTF-8。変換表は OS のものを使う。
+static bool shift_jis_to_utf8(std::string_view data, std::string& out) {
+    out.reserve(out.size() + data.size() + data.size() / 2);
+#ifdef _WIN32
+    // 行末 (CR/LF は2バイト文字の2バイト目に現れない) で区切った一定サイズずつ UTF-16 を経由し、
+    // 中間バッファをキャッシュに載る大きさに保ったまま出力へ1回の走査で書き出す
+    constexpr size_t kChunk = 64u << 10;
+    std::vector<wchar_t> wide;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t end = std::min(data.size(), pos + kChunk);
+        if (end < data.size()) {
+            size_t cut = end;
+            while (cut > pos && data[cut - 1] != '\n' && data[cut - 1] != '\r') --cut;
+            if (cut > pos) end = cut;
+            else end = std::min(data.size(), pos + srt_scan::find_line_break(data.substr(pos)) + 1);
+        }
+        const int len = (int)(end - pos);
+        const int need = MultiByteToWideChar(932, 0, data.data() + pos, len, nullptr, 0);
+        if (need <= 0) return false;
+        wide.resize((size_t)need);
+        MultiByteToWideChar(932, 0, data.data() + pos, len, wide.data(), need);
+        append_utf16_as_utf8([&](size_t i) { return (uint32_t)wide[i]; }, (size_t)need, out);
+        pos = end;
+    }
+    return true;
+#elif defined(SRT_HAVE_ICONV)
+    iconv_t cd = iconv_open("UTF-8", "CP932");
+    if (cd == (iconv_t)-1) cd = iconv_open("UTF-8", "SHIFT_JIS");
+    if (cd == (iconv_t)-1) return false;
+    char* in = const_cast<char*>(data.data());
+    size_t in_left = data.size();
+    size_t used = out.size();
+    out.resize(out.capacity());
+    while (in_left > 0) {
+        if (out.size() - used < 16) out.resize(out.size() * 2 + 64);
+        char* dst = &out[used];
+        size_t out_left = out.size() - used;
+        const size_t r = iconv(cd, &in, &in_left, &dst, &out_left);
+        used = out.size() - out_left;
+        if (r != (size_t)-1) break;
+        if (errno == E2BIG) continue;
+        // 変換できないバイト (EILSEQ) や途中で切れた文字 (EINVAL) は U+FFFD にして1バイト進める
+        out.resize(std::max(out.size(), used + 3));
+        std::memcpy(&out[used], "\xEF\xBF\xBD", 3);
+        used += 3;
+        ++in;
+        --in_left;
+    }
+    iconv_close(cd);
+    out.resize(used);
+    return true;
+#else
+    (void)data;
+    return false;
+#endif
+}
+
+bool transcode_to_utf8(std::string_view data, SrtEncoding encoding, std::string& out) {
+    switch (encoding) {
+    case SrtEncoding::Utf8:
+        out.append(strip_utf8_bom(data));
+        return true;
+    case SrtEncoding::Utf16Le:
+    case SrtEncoding::Utf16Be:
+        utf16_to_utf8(data, encoding == SrtEncoding::Utf16Be, out);
+        return true;
+    case SrtEncoding::ShiftJis:
+        return shift_jis_to_utf8(data, out);
+    }
+    return false;
+}
+
+bool decode_srt_text(std::string_view data, std::string& storage, std::string_view& text, SrtEncoding* encoding) {
+    const SrtEncoding detected = detect_srt_encoding(data);
+    if (encoding) *encoding = detected;
+    storage.clear();
+    if (detected != SrtEncoding::Utf8) {
+        if (transcode_to_utf8(data, detected, storage)) {
+            text = storage;
+            return true;
+        }
+        storage.clear();
+    }
+    // UTF-8 はコピーせず BOM を除いたビューを返す
+    text = strip_utf8_bom(data);
+    return detected == SrtEncoding::Utf8;
+}
+
+SrtCues parse_srt_buffer(std::string_view data) {
+    data = strip_utf8_bom(data);
+
+    if (data.size() >= kParallelParseThreshold) {
+        size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), data.size() / kParallelParseMinChunk);
+        if (workers > 1) return parse_srt_parallel(data, workers);
+    }
+
+    // 正規化後の本文は元の行より長くならないため、アリーナは入力サイズ分を一度だけ確保すれば足りる
+    SrtCues out;
+    out.arena.reserve(data.size() + 1);
+    parse_srt_range(data, out);
+    return out;
+}
+
+SrtCues parse_srt(const std::filesystem::path& path) {
+    SrtInputFile in;
+    if (!in.map(path)) {
+        SrtCues out;
+        parse_srt_stream(path, [&](const SrtCueView& cue) {
+            out.push_back(cue.start_ms, cue.end_ms, cue.text);
+            return true;
+        });
+        return out;
+    }
+    std::string decoded;
+    std::string_view text;
+    decode_srt_text(in.bytes(), decoded, text);
+    return parse_srt_buffer(text);
+}
+
+//---------------------------------------------------------------------
+// ストリーミングパース
+//---------------------------------------------------------------------
+bool SrtStreamParser::feed(std::string_view chunk) {
+    if (stopped_) return false;
+    pending_.append(chunk);
+    if (!started_) {
+        // BOM の判定には先頭3バイトが要る
+        if (pending_.size() < 3) return true;
+        pending_.erase(0, pending_.size() - strip_utf8_bom(pending_).size());
+        started_ = true;
+    }
+    return drain(false);
+}
+
+bool SrtStreamParser::finish() {
+    if (stopped_) return false;
+    if (!started_) {
+        pending_.erase(0, pending_.size() - strip_utf8_bom(pending_).size());
+        started_ = true;
+    }
+    const bool ok = drain(true);
+    pending_.clear();
+    return ok;
+}
+
+bool SrtStreamParser::drain(bool final) {
+    // 行末まで届いている部分だけを走査する。末尾の CR は CRLF の途中かもしれないので次に回す。
+    size_t limit = pending_.size();
+    if (!final) {
+        if (limit > 0 && pending_[limit - 1] == '\r') --limit;
+        const size_t br = limit > 0 ? std::string_view(pending_).find_last_of("\r\n", limit - 1) : std::string_view::npos;
+        if (br == std::string_view::npos) return true;
+        limit = br + 1;
+        // 前回の走査で何も確定しなかった場合、読み足した部分に空行が無ければブロックはまだ閉じていない
+        // (空行の無い巨大な入力で毎回先頭から走査し直さないため)
+        if (quiet_ > 0 && find_cue_boundary(std::string_view(pending_).substr(0, limit), quiet_ - 1) >= limit) {
+            quiet_ = limit;
+            return true;
+        }
+    }
+    const size_t consumed = scan_srt_blocks(std::string_view(pending_).substr(0, limit), final,
+        [&](int64_t start_ms, int64_t end_ms, std::string_view raw) {
+            text_.clear();
+            append_cue_text(raw, text_);
+            if (!on_cue_(SrtCueView{ start_ms, end_ms, text_ })) stopped_ = true;
+            return !stopped_;
+        });
+    // 残り (閉じていない最後のブロックと、行末に届いていない部分) をバッファの先頭へ詰める
+    pending_.erase(0, consumed);
+    quiet_ = consumed == 0 ? limit : 0;
+    return !stopped_;
+}
+
+// carry のうち、文字の途中で切らずに変換できる先頭部分の長さ
+static size_t transcodable_prefix(std::string_view carry, SrtEncoding encoding, bool eof) {
+    if (eof) return carry.size();
+    switch (encoding) {
+    case SrtEncoding::Utf16Le:
+    case SrtEncoding::Utf16Be: {
+        size_t n = carry.size() & ~(size_t)1;
+        if (n >= 2) {
+            const unsigned char* u = (const unsigned char*)carry.data() + n - 2;
+            const unsigned last = encoding == SrtEncoding::Utf16Be ? (u[0] << 8 | u[1]) : (u[1] << 8 | u[0]);
+            // 上位サロゲートは下位サロゲートと一緒に変換する
+            if (last >= 0xD800 && last <= 0xDBFF) n -= 2;
+        }
+        return n;
+    }
+    case SrtEncoding::ShiftJis: {
+        // CR/LF は2バイト文字の2バイト目に現れないため、行末の直後は文字の境界
+        const size_t br = carry.find_last_of("\r\n");
+        return br == std::string_view::npos ? 0 : br + 1;
+    }
+    default:
+        return carry.size();
+    }
+}
+
+bool parse_srt_stream(const std::filesystem::path& path, const SrtCueCallback& on_cue, size_t buffer_bytes, SrtEncoding* encoding) {
+#ifdef _WIN32
+    FILE* fp = _wfopen(path.c_str(), L"rb");
+#else
+    FILE* fp = fopen(path.c_str(), "rb");
+#endif
+    if (!fp) return false;
+
+    std::vector<char> buffer(std::max<size_t>(buffer_bytes, 4096));
+    SrtStreamParser parser(on_cue);
+    SrtEncoding detected = SrtEncoding::Utf8;
+    bool first = true;
+    bool bom = true;     // UTF-16: 最初の変換だけ先頭の BOM を除く
+    std::string carry;   // UTF-8 以外: 変換の区切り (文字・行の境界) に届いていない端数
+    std::string decoded; // UTF-8 以外: 1回分の変換結果
+    for (bool eof = false; !eof && !parser.stopped();) {
+        const size_t got = fread(buffer.data(), 1, buffer.size(), fp);
+        eof = got < buffer.size();
+        std::string_view chunk(buffer.data(), got);
+        if (first) {
+            // 読み込みの末尾は文字の途中で切れている可能性があるため、判定は最後の行末までで行う
+            const size_t br = chunk.find_last_of("\r\n");
+            detected = detect_srt_encoding(eof || br == std::string_view::npos ? chunk : chunk.substr(0, br + 1));
+            if (encoding) *encoding = detected;
+        }
+        first = false;
+        if (detected == SrtEncoding::Utf8) {
+            parser.feed(chunk);
+            continue;
+        }
+        carry.append(chunk);
+        const size_t n = transcodable_prefix(carry, detected, eof);
+        if (n == 0) continue;
+        const std::string_view piece = std::string_view(carry).substr(0, n);
+        decoded.clear();
+        bool converted = true;
+        if (detected == SrtEncoding::ShiftJis) {
+            converted = shift_jis_to_utf8(piece, decoded);
+        } else {
+            utf16_to_utf8(piece, detected == SrtEncoding::Utf16Be, decoded, bom);
+            bom = false;
+        }
+        if (!converted) {
+            // 変換できなければ以降は UTF-8 として読む (decode_srt_text と同じ扱い)
+            detected = SrtEncoding::Utf8;
+            parser.feed(carry);
+            carry.clear();
+        } else {
+            parser.feed(decoded);
+            carry.erase(0, n);
+        }
+    }
+    const bool ok = !ferror(fp);
+    fclose(fp);
+    if (!ok) return false;
+    parser.finish();
+    return true;
+}
+
+void assign_frames(SrtCues& cues, int rate, int scale) {
+    const size_t n = cues.size();
+    cues.start_frame.resize(n);
+    cues.end_frame.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        cues.start_frame[i] = ms_to_frame(cues.start_ms[i], rate, scale);
+        cues.end_frame[i] = std::max(ms_to_frame(cues.end_ms[i], rate, scale), cues.start_frame[i] + 1);
+    }
+}
+
+// 出力の最後のキューは常にアリーナの末尾にあるため、本文の追加は末尾の NUL を付け直すだけで済む。
+CoalesceStats coalesce_cues(SrtCues& cues, const CoalesceOptions& options, int rate, int scale) {
+    CoalesceStats st;
+    const size_t n = cues.size();
+    if (!options.enabled() || cues.start_frame.size() != n) return st;
+
+    SrtCues out;
+    out.start_ms.reserve(n);
+    out.end_ms.reserve(n);
+    out.start_frame.reserve(n);
+    out.end_frame.reserve(n);
+    out.text_offset.reserve(n);
+    out.text_length.reserve(n);
+    out.arena.reserve(cues.arena.size());
+
+    auto extend_last = [&](size_t i) {
+        const size_t last = out.size() - 1;
+        out.end_ms[last] = std::max(out.end_ms[last], cues.end_ms[i]);
+        out.end_frame[last] = std::max(ms_to_frame(out.end_ms[last], rate, scale), out.start_frame[last] + 1);
+    };
+    for (size_t i = 0; i < n; ++i) {
+        const std::string_view text = cues.text(i);
+        const bool touches_last = !out.empty() && out.end_frame.back() >= cues.start_frame[i];
+        if (options.merge_identical && touches_last && out.text(out.size() - 1) == text) {
+            extend_last(i);
+            ++st.merged_identical;
+            continue;
+        }
+        if (cues.end_frame[i] - cues.start_frame[i] < options.min_frames) {
+            if (options.short_mode == ShortCueMode::Drop) {
+                ++st.dropped;
+                continue;
+            }
+            if (options.short_mode == ShortCueMode::Merge && touches_last) {
+                extend_last(i);
+                out.arena.back() = '\n';
+                out.arena.append(text);
+                out.arena += '\0';
+                out.text_length.back() += 1 + (uint32_t)text.size();
+                ++st.merged_short;
+                continue;
+            }
+        }
+        out.start_ms.push_back(cues.start_ms[i]);
+        out.end_ms.push_back(cues.end_ms[i]);
+        out.start_frame.push_back(cues.start_frame[i]);
+        out.end_frame.push_back(cues.end_frame[i]);
+        out.text_offset.push_back(out.arena.size());
+        out.text_length.push_back((uint32_t)text.size());
+        out.arena.append(text);
+        out.arena += '\0';
+    }
+    if (st.saved()) cues = std::move(out);
+    return st;
+}
+
+// オブジェクトはフレーム [start_frame, end_frame) を占めるため、終了フレームと次の開始フレームが同じなら同じレイヤーに置ける。
+std::vector<int> assign_cue_layers(const SrtCues& cues, int max_layers) {
+    const size_t n = cues.size();
+    std::vector<int> layer(n, -1);
+    if (max_layers <= 0 || cues.start_frame.size() != n) return layer;
+
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return cues.start_frame[a] < cues.start_frame[b]; });
+
+    using Busy = std::pair<int, int>; // (終了フレーム, レイヤー)
+    std::priority_queue<Busy, std::vector<Busy>, std::greater<Busy>> busy;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> free_layers;
+    int opened = 0;
+    for (uint32_t i : order) {
+        const int start = cues.start_frame[i];
+        while (!busy.empty() && busy.top().first <= start) {
+            free_layers.push(busy.top().second);
+            busy.pop();
+        }
+        int l;
+        if (!free_layers.empty()) {
+            l = free_layers.top();
+            free_layers.pop();
+        } else if (opened < max_layers) {
+            l = opened++;
+        } else {
+            continue; // 上限に達した
+        }
+        layer[i] = l;
+        busy.push({ std::max(cues.end_frame[i], start + 1), l });
+    }
+    return layer;
+}
+
+//---------------------------------------------------------------------
+// 時刻範囲の読み込み (疎なシーク索引)
+//---------------------------------------------------------------------
+// "-->" を含む行はすべて時刻行の候補として数える。本文中の "-->" も含まれうるが、
+// 範囲が広がる (余分にパースする) だけで、実際のキューを取りこぼすことはない。
+SrtSeekIndex build_seek_index(std::string_view data) {
+    SrtSeekIndex index;
+    if (data.empty()) return index;
+
+    index.block_offset.push_back(0);
+    while (index.block_offset.back() < data.size()) {
+        const size_t from = (size_t)index.block_offset.back() + SrtSeekIndex::kBlockBytes;
+        index.block_offset.push_back(from < data.size() ? find_cue_boundary(data, from) : data.size());
+    }
+
+    const size_t blocks = index.block_offset.size() - 1;
+    std::vector<int64_t> min_start(blocks, INT64_MAX), max_end(blocks, INT64_MIN);
+    for (size_t j = 0; j < blocks; ++j) {
+        const size_t block_end = index.block_offset[j + 1];
+        size_t pos = index.block_offset[j];
+        while (pos < block_end) {
+            size_t arrow = srt_scan::find_arrow(data.substr(pos, block_end - pos));
+            if (arrow == std::string_view::npos) break;
+            arrow += pos;
+            // ブロックは行頭から始まるので、行頭はブロック内で見つかる
+            size_t line_begin = arrow;
+            while (line_begin > pos && data[line_begin - 1] != '\n' && data[line_begin - 1] != '\r') --line_begin;
+            const size_t line_end = arrow + srt_scan::find_line_break(data.substr(arrow));
+            const int64_t start_ms = parse_timestamp_ms(data.substr(line_begin, arrow - line_begin));
+            const int64_t end_ms = parse_timestamp_ms(data.substr(arrow + 3, line_end - arrow - 3));
+            if (start_ms >= 0 && end_ms > start_ms) {
+                min_start[j] = std::min(min_start[j], start_ms);
+                max_end[j] = std::max(max_end[j], end_ms);
+            }
+            pos = line_end;
+        }
+    }
+
+    index.prefix_max_end.resize(blocks);
+    index.suffix_min_start.resize(blocks);
+    int64_t running_end = INT64_MIN;
+    for (size_t j = 0; j < blocks; ++j) {
+        running_end = std::max(running_end, max_end[j]);
+        index.prefix_max_end[j] = running_end;
+    }
+    int64_t running_start = INT64_MAX;
+    for (size_t j = blocks; j-- > 0;) {
+        running_start = std::min(running_start, min_start[j]);
+        index.suffix_min_start[j] = running_start;
+    }
+    return index;
+}
+
+bool cue_overlaps_window(int64_t start_ms, int64_t end_ms, int64_t begin_ms, int64_t window_end_ms) {
+    return start_ms < window_end_ms && end_ms > begin_ms;
+}
+
+SrtCues parse_srt_window(std::string_view data, const SrtSeekIndex& index, int64_t begin_ms, int64_t end_ms) {
+    SrtCues out;
+    if (index.empty() || index.block_offset.back() != data.size() || end_ms <= begin_ms) return out;
+
+    // 終了時刻が begin_ms を超えるキューを最初に含みうるブロックから、
+    // 開始時刻が end_ms 未満のキューを最後に含みうるブロックまで
+    const size_t first = (size_t)(std::upper_bound(index.prefix_max_end.begin(), index.prefix_max_end.end(), begin_ms) - index.prefix_max_end.begin());
+    const size_t last = (size_t)(std::lower_bound(index.suffix_min_start.begin(), index.suffix_min_start.end(), end_ms) - index.suffix_min_start.begin());
+    if (first >= last) return out;
+
+    const size_t from = (size_t)index.block_offset[first];
+    const size_t to = (size_t)index.block_offset[last];
+    SrtCues range;
+    range.arena.reserve(to - from + 1);
+    parse_srt_range(data.substr(from, to - from), range);
+    return select_srt_window(range, begin_ms, end_ms);
+}
+
+SrtCues select_srt_window(const SrtCues& cues, int64_t begin_ms, int64_t end_ms) {
+    SrtCues out;
+    for (size_t i = 0; i < cues.size(); ++i) {
+        if (!cue_overlaps_window(cues.start_ms[i], cues.end_ms[i], begin_ms, end_ms)) continue;
+        out.push_back(cues.start_ms[i], cues.end_ms[i], cues.text(i));
+    }
+    return out;
+}
+
+void rebase_srt_cues(SrtCues& cues, int64_t origin_ms) {
+    for (size_t i = 0; i < cues.size(); ++i) {
+        cues.start_ms[i] = std::max<int64_t>(0, cues.start_ms[i] - origin_ms);
+        cues.end_ms[i] = std::max<int64_t>(cues.start_ms[i] + 1, cues.end_ms[i] - origin_ms);
+    }
+    cues.start_frame.clear();
+    cues.end_frame.clear();
+}
+
+//---------------------------------------------------------------------
+// 時刻の変換
+//---------------------------------------------------------------------
+bool TimingTransform::valid() const {
+    return std::isfinite(scale) && std::isfinite(offset_ms) && scale > 0;
+}
+
+TimingTransform two_point_sync(int64_t a_ms, int64_t x_ms, int64_t b_ms, int64_t y_ms) {
+    TimingTransform t;
+    if (a_ms != b_ms) t.scale = (double)(y_ms - x_ms) / (double)(b_ms - a_ms);
+    t.offset_ms = (double)x_ms - (double)a_ms * t.scale;
+    return t;
+}
+
+size_t apply_timing_transform(SrtCues& cues, const TimingTransform& transform) {
+    if (transform.identity() || !transform.valid()) return 0;
+    srt_scan::retime(cues.start_ms.data(), cues.end_ms.data(), cues.size(), transform.scale, transform.offset_ms);
+    cues.start_frame.clear();
+    cues.end_frame.clear();
+
+    // 終了が 0 以下になった (0 より前に終わる) キューを取り除く。残ったキューの本文はアリーナへ詰め直す。
+    const size_t n = cues.size();
+    size_t first = 0;
+    while (first < n && cues.end_ms[first] > 0) ++first;
+    if (first == n) return 0;
+    std::string arena;
+    arena.reserve(cues.arena.size());
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (cues.end_ms[i] <= 0) continue;
+        cues.start_ms[kept] = cues.start_ms[i];
+        cues.end_ms[kept] = cues.end_ms[i];
+        cues.text_length[kept] = cues.text_length[i];
+        cues.text_offset[kept] = arena.size();
+        arena.append(cues.arena, cues.text_offset[i], (size_t)cues.text_length[i] + 1); // NUL 終端ごと
+        ++kept;
+    }
+    cues.start_ms.resize(kept);
+    cues.end_ms.resize(kept);
+    cues.text_offset.resize(kept);
+    cues.text_length.resize(kept);
+    cues.arena = std::move(arena);
+    return n - kept;
+}
+
+//---------------------------------------------------------------------
+// 本文整形
+//---------------------------------------------------------------------
+void escape_text_value_newline(std::string_view s, std::string& out) {
+    out.clear();
+    out.reserve(s.size() + 8);
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '\\') {
+            out.push_back('\\');
+            out.push_back('\\');
+            continue;
+        }
+        if (c == '\r') {
+            if (i + 1 < s.size() && s[i + 1] == '\n') ++i;
+            out.push_back('\\');
+            out.push_back('n');
+            continue;
+        }
+        if (c == '\n') {
+            out.push_back('\\');
+            out.push_back('n');
+            continue;
+        }
+        out.push_back(c);
+    }
+}
+
+//---------------------------------------------------------------------
+// alias生成: テキスト + 標準描画 + 縁取り
+//---------------------------------------------------------------------
+AliasTemplate build_alias(const AliasStyle& style) {
+    AliasTemplate t;
+    std::string& out = t.text;
+    out.reserve(256);
+
+    // 数値は少数2桁程度に丸めて文字列化
+    auto append_num = [&](double v) {
+        char buf[64];
+        int n = std::snprintf(buf, sizeof(buf), "%.2f", v);
+        if (n > 0) out.append(buf, std::min((size_t)n, sizeof(buf) - 1));
+    };
+    // key=value 行を追加し、value の位置を記録する
+    auto append_item = [&](const char* key, AliasTemplate::Field field, auto&& append_value) {
+        out += key;
+        out += '=';
+        t.splices[field].offset = out.size();
+        append_value();
+        t.splices[field].length = out.size() - t.splices[field].offset;
+        out += "\r\n";
+    };
+
+    out += "[Object]\r\n";
+
+    // Object.0 テキスト (本文/フォント/色/サイズ)
+    out += "[Object.0]\r\n";
+    out += "effect.name=テキスト\r\n";
+    append_item("サイズ", AliasTemplate::FieldSize, [&] { append_num(style.size); });
+    append_item("文字色", AliasTemplate::FieldColor, [&] { out += style.color; });
+    if (!style.font.empty()) {
+        append_item("フォント", AliasTemplate::FieldFont, [&] { out += style.font; });
+    }
+    // 改行を含む本文は create 後に set_object_item_value で設定する。
+    append_item("テキスト", AliasTemplate::FieldText, [] {});
+
+    // Object.1 標準描画 (位置)
+    out += "[Object.1]\r\n";
+    out += "effect.name=標準描画\r\n";
+    append_item("X", AliasTemplate::FieldX, [&] { append_num(style.x); });
+    append_item("Y", AliasTemplate::FieldY, [&] { append_num(style.y); });
+
+    // Object.2 縁取り (縁色) ※任意
+    if (style.outline_enabled) {
+        out += "[Object.2]\r\n";
+        out += "effect.name=縁取り\r\n";
+        out += "サイズ=3\r\n";
+        out += "縁色=";
+        out += style.outline;
+        out += "\r\n";
+    }
+
+    return t;
+}
@@ -0,0 +1,338 @@
+#pragma once
+
+// SRTパース / 時刻変換 / 本文整形 / alias生成 (プラットフォーム非依存)
+// SrtImporter プラグインとベンチマークで共有する。<windows.h> には依存しない。
+// 前提: UTF-8 / UTF-16 / Shift_JIS 対応 (自動判定して UTF-8 に変換する)。改行コードは CRLF/CR/LF に対応。時間→フレームは切り捨て。
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// パース済みキュー。時刻は項目ごとの連続配列 (struct-of-arrays) に持ち、
+// 本文は1つのアリーナに NUL 区切りで連結して保持する (本文は normalize_text_value 済み)。
+struct SrtCues {
+    std::vector<int64_t> start_ms;
+    std::vector<int64_t> end_ms;
+    std::vector<int> start_frame; // assign_frames で編集セクション内のレート/スケールから設定する
+    std::vector<int> end_frame;
+    std::vector<size_t> text_offset;
+    std::vector<uint32_t> text_length;
+    std::string arena;
+
+    size_t size() const { return start_ms.size(); }
+    bool empty() const { return start_ms.empty(); }
+
+    // 本文はアリーナ内で NUL 終端されているため、data() をそのまま API に渡せる
+    std::string_view text(size_t i) const { return std::string_view(arena.data() + text_offset[i], text_length[i]); }
+
+    void clear() { *this = SrtCues{}; }
+
+    // 正規化済みの本文を持つキューを末尾に追加する
+    void push_back(int64_t start, int64_t end, std::string_view text) {
+        start_ms.push_back(start);
+        end_ms.push_back(end);
+        text_offset.push_back(arena.size());
+        text_length.push_back((uint32_t)text.size());
+        arena.append(text);
+        arena += '\0';
+    }
+
+    // other のキューを末尾に連結する (本文の位置はずらして付け替える)
+    void append(const SrtCues& other) {
+        const size_t base = arena.size();
+        start_ms.insert(start_ms.end(), other.start_ms.begin(), other.start_ms.end());
+        end_ms.insert(end_ms.end(), other.end_ms.begin(), other.end_ms.end());
+        text_length.insert(text_length.end(), other.text_length.begin(), other.text_length.end());
+        text_offset.reserve(text_offset.size() + other.text_offset.size());
+        for (size_t off : other.text_offset) text_offset.push_back(base + off);
+        arena += other.arena;
+    }
+};
+
+//---------------------------------------------------------------------
+// SRT入力 (読み取り専用ビュー)
+//---------------------------------------------------------------------
+// ファイル全体を読み取り専用のバイト列として提供する。
+// 可能な限りメモリマップし、パーサはマップされたバイト列を直接走査する (ヒープへのコピーなし)。
+// マップに失敗した場合は一定サイズずつ読み込んだバッファで代替する。サイズは64bitで扱う。
+class SrtInputFile {
+public:
+    SrtInputFile() = default;
+    ~SrtInputFile() { close(); }
+    SrtInputFile(const SrtInputFile&) = delete;
+    SrtInputFile& operator=(const SrtInputFile&) = delete;
+
+    bool open(const std::filesystem::path& path);
+    // メモリマップだけを試す (空のファイルは成功)。マップできなければ読み込みでは代替せず false を返す。
+    bool map(const std::filesystem::path& path);
+    void close();
+
+    std::string_view bytes() const { return view_; }
+    bool mapped() const { return map_base_ != nullptr; }
+
+private:
+    enum class MapResult { Mapped, Empty, Unreadable, Failed };
+
+    // フォールバック読み込みの1回あたりのサイズ
+    static constexpr size_t kReadChunk = 4u << 20;
+
+    MapResult map_file(const std::filesystem::path& path, uint64_t& size);
+    bool read_chunked(const std::filesystem::path& path, uint64_t size_hint);
+
+    std::string_view view_;
+    void* map_base_ = nullptr;
+    uint64_t map_size_ = 0;
+    std::string fallback_;
+};
+
+//---------------------------------------------------------------------
+// SRTパース (UTF-8 + CRLF/CR/LF対応。parse_srt / parse_srt_stream は UTF-16 / Shift_JIS を UTF-8 に変換してから渡す)
+//---------------------------------------------------------------------
+// 時刻欄 "HH:MM:SS,mmm" (ミリ秒区切りは "." も可) を整数ミリ秒に変換する。失敗時は -1。
+int64_t parse_timestamp_ms(std::string_view s);
+
+// ミリ秒 → フレーム (切り捨て)。frame = ms * rate / (1000 * scale) を64bit整数で正確に計算する。
+int ms_to_frame(int64_t ms, int rate, int scale);
+
+// 先頭の UTF-8 BOM を取り除いたビューを返す
+std::string_view strip_utf8_bom(std::string_view data);
+
+// 入力の文字コード
+enum class SrtEncoding {
+    Utf8,
+    Utf16Le,
+    Utf16Be,
+    ShiftJis, // CP932
+};
+
+const char* srt_encoding_name(SrtEncoding encoding);
+
+// BOM、UTF-8 としての妥当性 (ベクトル化した検証)、UTF-16 / Shift_JIS の特徴の順に文字コードを推定する。
+// どれにも当てはまらない場合は Utf8 を返す (従来通り、不正なバイトはそのまま扱う)。
+SrtEncoding detect_srt_encoding(std::string_view data);
+
+// data を encoding から UTF-8 に変換して out の末尾に追加する (BOM は除く)。
+// Shift_JIS の変換は OS の変換表 (Windows: コードページ932、その他: iconv) を使い、使えなければ false。
+bool transcode_to_utf8(std::string_view data, SrtEncoding encoding, std::string& out);
+
+// data の文字コードを判定し、パーサに渡す UTF-8 のビューを text に返す。
+// UTF-8 は BOM を除いた data をそのまま返し (コピーなし)、それ以外は storage へ1回の走査で変換する。
+// 変換できなかった場合は false を返し、text には BOM を除いた data を入れる。
+bool decode_srt_text(std::string_view data, std::string& storage, std::string_view& text, SrtEncoding* encoding = nullptr);
+
+// UTF-8 のバッファ全体をパースする (他の文字コードは decode_srt_text で変換してから渡す)。
+// 大きい入力は空行境界で分割して並列にパースする。
+// キューの時刻はミリ秒で返す。フレームへの変換は assign_frames で行う。
+SrtCues parse_srt_buffer(std::string_view data);
+
+// BOM 除去済みの data を空行境界で workers 個に分割し、並列にパースする (結果は逐次パースと同一)。
+SrtCues parse_srt_parallel(std::string_view data, size_t workers);
+
+// ファイルを読み込み、文字コードを判定して UTF-8 に変換してからパースする。
+// メモリマップできないファイルは parse_srt_stream で流し読みする。
+SrtCues parse_srt(const std::filesystem::path& path);
+
+//---------------------------------------------------------------------
+// ストリーミングパース
+//---------------------------------------------------------------------
+// 1キュー分。本文は正規化済みで、コールバックの呼び出し中だけ有効。
+struct SrtCueView {
+    int64_t start_ms;
+    int64_t end_ms;
+    std::string_view text;
+};
+
+// false を返すとパースを中断する
+using SrtCueCallback = std::function<bool(const SrtCueView& cue)>;
+
+// 流し読みの1回あたりの読み込みサイズ
+inline constexpr size_t kSrtStreamBufferBytes = 256u << 10;
+
+// UTF-8 のバイト列を少しずつ受け取り、キューが確定するたびにコールバックへ渡す。
+// 保持するのは未処理の入力 (最後の読み込み分と、空行でまだ閉じていない最後のブロック) だけなので、
+// メモリは読み込みサイズと最長のキューで頭打ちになる。結果は同じ入力を parse_srt_buffer に渡した場合と同一。
+class SrtStreamParser {
+public:
+    explicit SrtStreamParser(SrtCueCallback on_cue) : on_cue_(std::move(on_cue)) {}
+
+    // 続きのバイト列を渡す。区切りはどこでもよい (行・キューの途中や CRLF の間でも可)。中断されたら false。
+    bool feed(std::string_view chunk);
+    // 入力の終わり。保留していた最後のキューを渡す。中断されたら false。
+    bool finish();
+
+    bool stopped() const { return stopped_; }
+    size_t pending_bytes() const { return pending_.size(); }
+
+private:
+    bool drain(bool final);
+
+    SrtCueCallback on_cue_;
+    std::string pending_; // 未処理の入力
+    std::string text_;    // 正規化した本文 (コールバックに渡す)
+    size_t quiet_ = 0;    // 前回の走査で何も確定しなかった場合、走査した長さ
+    bool started_ = false; // 先頭の BOM を確認済みか
+    bool stopped_ = false;
+};
+
+// ファイル全体を読み込まず、buffer_bytes ずつ読みながらキューを1つずつ on_cue に渡す。
+// 文字コードは最初の読み込み分で判定し (detect_srt_encoding と同じ規則)、UTF-8 以外は読み込みごとに変換する。
+// Shift_JIS を変換できない環境では UTF-8 として読む。ファイルを開けない・読み込みに失敗した場合は false。
+bool parse_srt_stream(const std::filesystem::path& path, const SrtCueCallback& on_cue,
+    size_t buffer_bytes = kSrtStreamBufferBytes, SrtEncoding* encoding = nullptr);
+
+void assign_frames(SrtCues& cues, int rate, int scale);
+
+// 短いキューの扱い (coalesce_cues)
+enum class ShortCueMode {
+    Keep,  // そのまま残す
+    Drop,  // 削除する
+    Merge, // 直前のキューと接して (重なって) いれば、その本文に改行して追加し、終了時刻を延ばす。接していなければ残す
+};
+
+// キューの結合の設定。既定ではなにもしない。
+struct CoalesceOptions {
+    bool merge_identical = false; // 本文が同じで、フレームが接する・重なる連続キューを1つにまとめる
+    int min_frames = 0;           // これより短い (フレーム数) キューを short_mode で扱う
+    ShortCueMode short_mode = ShortCueMode::Keep;
+
+    bool enabled() const { return merge_identical || (min_frames > 0 && short_mode != ShortCueMode::Keep); }
+};
+
+// 結合で減ったキュー数の内訳
+struct CoalesceStats {
+    size_t merged_identical = 0;
+    size_t dropped = 0;
+    size_t merged_short = 0;
+
+    size_t saved() const { return merged_identical + dropped + merged_short; }
+};
+
+// 連続するキューを結合してオブジェクト数を減らす。assign_frames(cues, rate, scale) の後に呼ぶ (判定はフレーム単位)。
+// キューはファイル上の順に見る。結合したキューは終了時刻を延ばし、終了フレームは延ばした時刻から assign_frames と同じく求め直す
+// (1フレームに満たないキューの最低1フレームを引き継ぐと、次のキューに食い込むため)。
+CoalesceStats coalesce_cues(SrtCues& cues, const CoalesceOptions& options, int rate, int scale);
+
+// 重なるキューを別々のレイヤーに振り分ける。assign_frames の後に呼ぶ。
+// 開始フレーム順に走査し、空いている最も小さいレイヤーへ割り当てる (使用中のレイヤーは終了フレームの最小ヒープで管理する)。
+// 戻り値はキューごとのレイヤー (0 始まりの相対位置)。max_layers 個のレイヤーに収まらないキューは -1。
+std::vector<int> assign_cue_layers(const SrtCues& cues, int max_layers);
+
+//---------------------------------------------------------------------
+// 時刻の変換
+//---------------------------------------------------------------------
+// ミリ秒の時刻の一次変換 t' = t * scale + offset_ms。結果は最も近いミリ秒に丸める。
+// 変換後に 0 より前に終わるキューは取り除き、0 をまたぐキューは開始だけを 0 にする。
+// 一律にずらす (offset_ms)、伸縮する (scale。25fps 基準の字幕を 23.976fps のプロジェクトに合わせるなら 25 / 23.976)、
+// 2点同期 (two_point_sync) のいずれもこの形で表す。
+struct TimingTransform {
+    double scale = 1.0;
+    double offset_ms = 0.0;
+
+    bool identity() const { return scale == 1.0 && offset_ms == 0.0; }
+    // 時刻の前後関係が保たれる変換か (scale が正、どちらも有限)
+    bool valid() const;
+};
+
+// 時刻 a_ms を x_ms に、b_ms を y_ms に移す変換。a_ms == b_ms の場合は a_ms を x_ms に移す平行移動。
+TimingTransform two_point_sync(int64_t a_ms, int64_t x_ms, int64_t b_ms, int64_t y_ms);
+
+// start_ms / end_ms の全体に変換を適用する (assign_frames の前に呼ぶ。フレームは求め直す必要がある)。
+// 連続配列を1回ずつ走査するベクトル化したパスで、終了は開始 + 1ms 以上に保つ。valid() でない変換は何もしない。
+// 取り除いたキューの数を返す (取り除いた場合だけ配列とアリーナを詰め直す)。
+size_t apply_timing_transform(SrtCues& cues, const TimingTransform& transform);
+
+//---------------------------------------------------------------------
+// 時刻範囲の読み込み (疎なシーク索引)
+//---------------------------------------------------------------------
+// 入力を空行境界で約 kBlockBytes ごとのブロックに分け、ブロックごとの時刻の範囲を持つ。
+// 終了時刻の累積最大と開始時刻の後方累積最小はどちらも単調なので、時刻範囲と重なりうるブロックを二分探索で絞れる
+// (キューが時刻順に並んでいない入力でも取りこぼさない)。
+struct SrtSeekIndex {
+    static constexpr size_t kBlockBytes = 64u << 10;
+
+    std::vector<uint64_t> block_offset;    // ブロック先頭のバイト位置。末尾に入力の長さを加えた blocks()+1 個
+    std::vector<int64_t> prefix_max_end;   // 先頭からブロック j までのキューの終了時刻の最大値
+    std::vector<int64_t> suffix_min_start; // ブロック j 以降のキューの開始時刻の最小値
+
+    size_t blocks() const { return prefix_max_end.size(); }
+    bool empty() const { return prefix_max_end.empty(); }
+};
+
+// BOM 除去済みの data から索引を作る。時刻行 ("-->" を含む行) だけを走査し、本文は読まない。
+SrtSeekIndex build_seek_index(std::string_view data);
+
+// [begin_ms, end_ms) と重なるキューだけを返す。索引で絞ったブロックだけをパースする。
+SrtCues parse_srt_window(std::string_view data, const SrtSeekIndex& index, int64_t begin_ms, int64_t end_ms);
+
+// パース済みの cues から [begin_ms, end_ms) と重なるキューを取り出す
+SrtCues select_srt_window(const SrtCues& cues, int64_t begin_ms, int64_t end_ms);
+
+// キュー [start_ms, end_ms) が範囲 [begin_ms, window_end_ms) と重なるか (parse_srt_window / select_srt_window と同じ判定)
+bool cue_overlaps_window(int64_t start_ms, int64_t end_ms, int64_t begin_ms, int64_t window_end_ms);
+
+// origin_ms を 0 とする時刻にずらす (origin より前に始まるキューは 0 から始める)
+void rebase_srt_cues(SrtCues& cues, int64_t origin_ms);
+
+//---------------------------------------------------------------------
+// 本文整形
+//---------------------------------------------------------------------
+// テキスト設定向けに改行を正規化し、out の末尾に追加する。
+void normalize_text_value(std::string_view s, std::string& out);
+
+// API値に含めるため、実改行を \n へエスケープして out に書き出す (out は使い回す)
+void escape_text_value_newline(std::string_view s, std::string& out);
+
+//---------------------------------------------------------------------
+// alias生成: テキスト + 標準描画 + 縁取り
+//---------------------------------------------------------------------
+// alias に書き込む見た目の設定 (文字列は UTF-8)
+struct AliasStyle {
+    double x = 0.0;
+    double y = 0.0;
+    double size = 40.0;
+    std::string font;
+    std::string color = "ffffff";
+    std::string outline = "000000";
+    bool outline_enabled = true;
+};
+
+// インポート1回分の alias。設定から一度だけ組み立て、全キューの create で共有する。
+// キューごとに値を差し替える可能性のある欄は値の位置 (splice) を記録しておき、
+// 差し替える場合も alias 全体を組み立て直さず、区間のコピーだけで済むようにする。
+struct AliasTemplate {
+    // alias 内での出現順に並べること
+    enum Field { FieldSize, FieldColor, FieldFont, FieldText, FieldX, FieldY, FieldCount };
+    struct Splice {
+        size_t offset = std::string::npos; // 値の先頭 (欄が無ければ npos)
+        size_t length = 0;
+    };
+
+    std::string text; // 差し替え無しの alias
+    std::array<Splice, FieldCount> splices{};
+
+    const char* c_str() const { return text.c_str(); }
+
+    // overrides のうち空でない欄を差し替えた alias を out に書き出す。out は呼び出し側で使い回す。
+    const char* render(const std::array<std::string_view, FieldCount>& overrides, std::string& out) const {
+        out.clear();
+        size_t copied = 0;
+        for (int f = 0; f < FieldCount; ++f) {
+            const Splice& sp = splices[f];
+            if (sp.offset == std::string::npos || overrides[f].empty()) continue;
+            out.append(text, copied, sp.offset - copied);
+            out.append(overrides[f]);
+            copied = sp.offset + sp.length;
+        }
+        out.append(text, copied, std::string::npos);
+        return out.c_str();
+    }
+};
+
+// テキスト本体は create 後に set_object_item_value で設定するため、alias はキューに依存しない。
+// インポートごとに1回だけ呼ぶ。
+AliasTemplate build_alias(const AliasStyle& style);
@@ -0,0 +1,638 @@
+#include "srt_import.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static LOG_HANDLE* g_logger = nullptr;
+
+void set_import_logger(LOG_HANDLE* logger) {
+    g_logger = logger;
+}
+
+//---------------------------------------------------------------------
+// インポート準備 (編集セクション外)
+//---------------------------------------------------------------------
+// 指定された時刻の変換をミリ秒の時刻全体へ適用する
+static void retime_cues(ImportBatch& batch) {
+    const ImportOptions& opt = batch.options;
+    SrtCues& cues = batch.cues;
+    TimingTransform timing = opt.timing;
+    if (opt.sync) {
+        if (opt.sync_cue[0] >= cues.size() || opt.sync_cue[1] >= cues.size()) {
+            if (g_logger) {
+                g_logger->warn(g_logger, (L"SRT: sync cue is out of range (" + std::to_wstring(cues.size()) + L" cues), timing left unchanged").c_str());
+            }
+            return;
+        }
+        timing = two_point_sync(cues.start_ms[opt.sync_cue[0]], opt.sync_ms[0], cues.start_ms[opt.sync_cue[1]], opt.sync_ms[1]);
+    }
+    if (timing.identity()) return;
+    if (!timing.valid()) {
+        // 2点の前後関係が逆など、時刻の順序が入れ替わる変換は適用しない
+        if (g_logger) g_logger->warn(g_logger, L"SRT: timing transform would reverse cue order, timing left unchanged");
+        return;
+    }
+    size_t dropped;
+    {
+        PhaseTimer timer(batch.metrics, ImportMetrics::PhaseRetime, true);
+        dropped = apply_timing_transform(cues, timing);
+    }
+    if (dropped > 0 && g_logger) {
+        g_logger->info(g_logger, (L"SRT: " + std::to_wstring(dropped) + L" cues end before 0 after the timing transform and were skipped").c_str());
+    }
+}
+
+// ファイル読み込み・パース・本文の正規化・alias生成は編集セクションの外で済ませておき、
+// 編集セクション内ではオブジェクト生成だけを行う。
+void prepare_import_batch(ImportBatch& batch) {
+    ImportMetrics& m = batch.metrics;
+    const ImportOptions& opt = batch.options;
+    SrtInputFile in;
+    bool mapped;
+    {
+        PhaseTimer timer(m, ImportMetrics::PhaseRead, true);
+        mapped = in.map(batch.path);
+    }
+    bool loaded = false;
+    if (mapped) {
+        loaded = true;
+        m.bytes = in.bytes().size();
+
+        // キャッシュのキーには内容のハッシュを含めるため、ヒットしても元ファイルは一度走査する。
+        // ハッシュは変換前のバイト列に対して取るので、ヒットした場合は文字コードの変換も不要。
+        SrtCacheKey key;
+        bool keyed = false;
+        if (batch.options.use_cache) {
+            PhaseTimer timer(m, ImportMetrics::PhaseHash, true);
+            keyed = make_srt_cache_key(batch.path, in.bytes(), key);
+        }
+        const SrtParseCache cache(batch.options.cache_dir.empty() ? default_srt_cache_dir() : batch.options.cache_dir,
+            batch.options.cache_max_bytes);
+        if (keyed) {
+            PhaseTimer timer(m, ImportMetrics::PhaseCacheLoad, true);
+            m.cache_hit = cache.load(key, batch.cues);
+        }
+        std::string decoded;
+        std::string_view data;
+        if (!m.cache_hit) {
+            PhaseTimer timer(m, ImportMetrics::PhaseNormalize, true);
+            SrtEncoding encoding = SrtEncoding::Utf8;
+            if (!decode_srt_text(in.bytes(), decoded, data, &encoding) && g_logger) {
+                std::wstring msg = L"SRT: cannot convert from ";
+                for (const char* c = srt_encoding_name(encoding); *c; ++c) msg.push_back((wchar_t)*c);
+                g_logger->warn(g_logger, (msg + L", reading as UTF-8").c_str());
+            }
+            m.encoding = srt_encoding_name(encoding);
+            m.bytes = data.size();
+        }
+        if (m.cache_hit) {
+            if (opt.window) batch.cues = select_srt_window(batch.cues, opt.window_begin_ms, opt.window_end_ms);
+        } else if (opt.window) {
+            // 範囲だけの読み込みはパース結果を保存しない (範囲外のキューを持たないため)。索引の方を再利用する。
+            SrtSeekIndex index;
+            {
+                PhaseTimer timer(m, ImportMetrics::PhaseIndex, true);
+                if (!keyed || !cache.load_index(key, index)) {
+                    index = build_seek_index(data);
+                    if (keyed && !index.empty() && !cache.store_index(key, index) && g_logger) {
+                        g_logger->warn(g_logger, L"SRT seek index cache write failed");
+                    }
+                }
+            }
+            PhaseTimer timer(m, ImportMetrics::PhaseParse, true);
+            batch.cues = parse_srt_window(data, index, opt.window_begin_ms, opt.window_end_ms);
+        } else {
+            {
+                // マップしたページの読み込みは走査時に起きるため、実際の読み込み時間の多くはここに含まれる
+                PhaseTimer timer(m, ImportMetrics::PhaseParse, true);
+                batch.cues = parse_srt_buffer(data);
+            }
+            if (keyed && !batch.cues.empty()) {
+                PhaseTimer timer(m, ImportMetrics::PhaseCacheStore, true);
+                if (!cache.store(key, batch.cues) && g_logger) g_logger->warn(g_logger, L"SRT parse cache write failed");
+            }
+        }
+    } else {
+        // マップできないファイル (一部のネットワークドライブなど) は全体を読み込まず、固定サイズのバッファで流し読みする。
+        // 範囲外のキューは受け取った時点で捨てる。内容のハッシュを先に取れないため、パースキャッシュは使わない。
+        SrtEncoding encoding = SrtEncoding::Utf8;
+        {
+            PhaseTimer timer(m, ImportMetrics::PhaseParse, true);
+            loaded = parse_srt_stream(batch.path, [&](const SrtCueView& cue) {
+                if (!opt.window || cue_overlaps_window(cue.start_ms, cue.end_ms, opt.window_begin_ms, opt.window_end_ms)) {
+                    batch.cues.push_back(cue.start_ms, cue.end_ms, cue.text);
+                }
+                return true;
+            }, kSrtStreamBufferBytes, &encoding);
+        }
+        if (loaded) {
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(batch.path, ec);
+            if (!ec) m.bytes = size;
+            m.encoding = srt_encoding_name(encoding);
+        }
+    }
+    if (loaded) {
+        if (opt.window && opt.rebase) rebase_srt_cues(batch.cues, opt.window_begin_ms);
+        retime_cues(batch);
+        m.cues = batch.cues.size();
+    }
+    // alias はキューに依存しないため1インポートにつき1回だけ組み立てる
+    PhaseTimer timer(m, ImportMetrics::PhaseAlias, true);
+    batch.alias = build_alias(batch.style);
+}
+
+// ファイル単位で仕事を取り合う。1ファイルが大きい場合は parse_srt_buffer 自身も並列にパースする。
+void prepare_import_batches(std::vector<std::unique_ptr<ImportBatch>>& batches, size_t workers) {
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, batches.size());
+    std::atomic<size_t> next{ 0 };
+    auto run = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < batches.size();) {
+            try {
+                prepare_import_batch(*batches[i]);
+            } catch (...) {
+                batches[i]->cues.clear();
+            }
+        }
+    };
+    // 呼び出しスレッドも処理する。スレッドを作れなければ作れた分だけで処理する。
+    std::vector<std::thread> threads;
+    threads.reserve(workers > 0 ? workers - 1 : 0);
+    for (size_t k = 1; k < workers; ++k) {
+        try {
+            threads.emplace_back(run);
+        } catch (...) {
+            break;
+        }
+    }
+    run();
+    for (auto& t : threads) t.join();
+}
+
+//---------------------------------------------------------------------
+// テキストオブジェクト生成
+//---------------------------------------------------------------------
+static bool set_item(EDIT_SECTION* edit, OBJECT_HANDLE obj, LPCWSTR effect, LPCWSTR item, const char* value) {
+    return edit->set_object_item_value(obj, effect, item, value);
+}
+
+// 読み戻した本文に改行が反映されているか
+static bool has_multiline_hint(const char* got) {
+    if (!got) return false;
+    std::string_view current(got);
+    return current.find('\n') != std::string_view::npos
+        || current.find("\\n") != std::string_view::npos
+        || current.find("\\N") != std::string_view::npos;
+}
+
+// 本文の設定は読み戻し後の再設定と区別して計測する
+static bool set_text(EDIT_SECTION* edit, OBJECT_HANDLE obj, const char* value, ImportMetrics::Phase phase, ImportMetrics& metrics) {
+    const auto t0 = ImportMetrics::Clock::now();
+    const bool ok = set_item(edit, obj, L"テキスト", L"テキスト", value);
+    metrics.add(phase, t0, ImportMetrics::Clock::now());
+    if (!ok) ++metrics.api_failures[ImportMetrics::ApiSetItemValue];
+    return ok;
+}
+
+// obj に本文を設定する。複数行の本文は nl の判定結果 (または options.newline_mode) に従って渡す。
+static void set_cue_text(std::string_view text_value, OBJECT_HANDLE obj, const ImportOptions& options, NewlineState& nl, ImportMetrics& metrics, EDIT_SECTION* edit) {
+    // 複数行の本文をどの形式で渡すか。Unknown は実改行で設定して読み戻しで確認する。
+    NewlineState::Encoding use = NewlineState::Raw;
+    if (text_value.find('\n') != std::string_view::npos) {
+        switch (options.newline_mode) {
+        case NewlineMode::Auto: use = nl.resolved; break;
+        case NewlineMode::Raw: use = NewlineState::Raw; break;
+        case NewlineMode::Escaped: use = NewlineState::Escaped; break;
+        case NewlineMode::Verify: use = NewlineState::Unknown; break;
+        }
+    }
+
+    if (use == NewlineState::Escaped) {
+        escape_text_value_newline(text_value, nl.scratch);
+        if (!set_text(edit, obj, nl.scratch.c_str(), ImportMetrics::PhaseSetText, metrics)) {
+            if (g_logger) g_logger->warn(g_logger, L"set_object_item_value(text, escaped newline) failed");
+        }
+        return;
+    }
+
+    // text_value は NUL 終端済み
+    if (!set_text(edit, obj, text_value.data(), ImportMetrics::PhaseSetText, metrics)) {
+        if (g_logger) g_logger->warn(g_logger, L"set_object_item_value(text, raw newline) failed");
+        return;
+    }
+    if (use == NewlineState::Raw) return;
+
+    // 実改行が反映されない環境向けに、必要時のみ \n 形式で再設定を試す
+    const auto t0 = ImportMetrics::Clock::now();
+    const char* got = edit->get_object_item_value(obj, L"テキスト", L"テキスト");
+    metrics.add(ImportMetrics::PhaseReadBack, t0, ImportMetrics::Clock::now());
+    if (!got) ++metrics.api_failures[ImportMetrics::ApiGetItemValue];
+    const bool auto_probe = (options.newline_mode == NewlineMode::Auto);
+    if (has_multiline_hint(got)) {
+        if (auto_probe) {
+            nl.resolved = NewlineState::Raw;
+            if (g_logger) g_logger->info(g_logger, L"multiline text: raw newline accepted");
+        }
+        return;
+    }
+    escape_text_value_newline(text_value, nl.scratch);
+    if (!set_text(edit, obj, nl.scratch.c_str(), ImportMetrics::PhaseReset, metrics)) {
+        if (g_logger) g_logger->warn(g_logger, L"set_object_item_value(text, escaped newline) failed");
+        return;
+    }
+    // 読み戻しに失敗した場合は判定せず、次の複数行本文で再度確認する
+    if (auto_probe && got) {
+        nl.resolved = NewlineState::Escaped;
+        if (g_logger) g_logger->info(g_logger, L"multiline text: escaped newline required");
+    }
+}
+
+// cues[i] のオブジェクトを生成する。失敗時は nullptr。
+static OBJECT_HANDLE create_cue_object(const SrtCues& cues, size_t i, int layer, const AliasTemplate& alias, ImportMetrics& metrics, EDIT_SECTION* edit) {
+    const int start_frame = cues.start_frame[i];
+    int length = std::max(1, cues.end_frame[i] - start_frame);
+    const auto t0 = ImportMetrics::Clock::now();
+    OBJECT_HANDLE obj = edit->create_object_from_alias(alias.c_str(), layer, start_frame, length);
+    metrics.add(ImportMetrics::PhaseCreate, t0, ImportMetrics::Clock::now());
+    if (!obj) {
+        ++metrics.api_failures[ImportMetrics::ApiCreateObject];
+        if (g_logger) g_logger->warn(g_logger, L"create_object_from_alias failed");
+    }
+    return obj;
+}
+
+// cues[i] を置くレイヤー (0始まり)。上限に収まらなかったキューは -1。
+static int cue_layer(const ImportOptions& options, const ImportProgress& progress, size_t i) {
+    const int base = std::max(0, options.layer - 1); // UIは1始まり、APIは0始まり
+    if (!options.pack_layers) return base;
+    if (i >= progress.layers.size() || progress.layers[i] < 0) return -1;
+    return base + progress.layers[i];
+}
+
+// フレーム位置を確定し、キューを結合し、pack_layers ならレイヤーを割り当てる (インポートにつき1回)
+// 結合はフレーム単位で判定するため、プロジェクトのレート/スケールが分かるここで行う。
+static void prepare_placement(SrtCues& cues, const ImportOptions& options, ImportProgress& progress, ImportMetrics& m, EDIT_SECTION* edit) {
+    if (progress.frames_ready) return;
+    {
+        PhaseTimer timer(m, ImportMetrics::PhaseFrames);
+        assign_frames(cues, edit->info->rate, edit->info->scale);
+    }
+    progress.frames_ready = true;
+    if (options.coalesce.enabled()) {
+        PhaseTimer timer(m, ImportMetrics::PhaseCoalesce);
+        progress.coalesce = coalesce_cues(cues, options.coalesce, edit->info->rate, edit->info->scale);
+        m.coalesced = progress.coalesce.saved();
+    }
+    if (!options.pack_layers) return;
+    PhaseTimer timer(m, ImportMetrics::PhaseLayers);
+    progress.layers = assign_cue_layers(cues, options.max_layers);
+    progress.overflow = (size_t)std::count(progress.layers.begin(), progress.layers.end(), -1);
+    if (progress.overflow && g_logger) {
+        g_logger->warn(g_logger, (L"SRT import: " + std::to_wstring(progress.overflow) + L" overlapping cues exceed the layer limit and were skipped").c_str());
+    }
+}
+
+int used_layer_count(const ImportBatch& batch, const ImportProgress& progress) {
+    if (!batch.options.pack_layers || progress.layers.empty()) return 1;
+    return std::max(1, *std::max_element(progress.layers.begin(), progress.layers.end()) + 1);
+}
+
+size_t apply_entries_to_timeline(const SrtCues& cues, size_t begin, size_t end, const ImportOptions& options, const AliasTemplate& alias, ImportProgress& progress, ImportMetrics& metrics, EDIT_SECTION* edit) {
+    if (progress.objects.size() < cues.size()) progress.objects.resize(cues.size(), nullptr);
+    size_t inserted = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const int layer = cue_layer(options, progress, i);
+        if (layer < 0) continue;
+        OBJECT_HANDLE obj = create_cue_object(cues, i, layer, alias, metrics, edit);
+        if (!obj) continue;
+        ++inserted;
+        progress.objects[i] = obj;
+        set_cue_text(cues.text(i), obj, options, progress.newline, metrics, edit);
+    }
+    return inserted;
+}
+
+void apply_import_step(ImportBatch& batch, ImportProgress& progress, EDIT_SECTION* edit) {
+    ImportMetrics& m = batch.metrics;
+    const auto t0 = ImportMetrics::Clock::now();
+    prepare_placement(batch.cues, batch.options, progress, m, edit);
+    const size_t total = batch.cues.size();
+    size_t step = batch.options.batch_size > 0 ? (size_t)batch.options.batch_size : total;
+    size_t end = std::min(total, progress.next + step);
+    const size_t inserted = apply_entries_to_timeline(batch.cues, progress.next, end, batch.options, batch.alias, progress, m, edit);
+    progress.inserted += inserted;
+    m.inserted += inserted;
+    ++m.edit_sections;
+    m.spans.push_back({ "apply", 1, m.since_origin_us(t0), m.since_origin_us(ImportMetrics::Clock::now()), progress.next, end });
+    progress.next = end;
+}
+
+//---------------------------------------------------------------------
+// 差分更新
+//---------------------------------------------------------------------
+ImportedLayer record_imported_layer(const ImportBatch& batch, const ImportProgress& progress) {
+    const SrtCues& cues = batch.cues;
+    ImportedLayer layer;
+    layer.cues.reserve(cues.size());
+    std::string escaped;
+    for (size_t i = 0; i < cues.size(); ++i) {
+        OBJECT_HANDLE obj = i < progress.objects.size() ? progress.objects[i] : nullptr;
+        if (!obj) continue;
+        const std::string_view text = cues.text(i);
+        const uint64_t text_hash = srt_content_hash(text);
+        uint64_t escaped_hash = text_hash;
+        if (text.find_first_of("\n\\") != std::string_view::npos) {
+            escape_text_value_newline(text, escaped);
+            escaped_hash = srt_content_hash(escaped);
+        }
+        layer.cues.push_back({ cues.start_ms[i], cues.end_ms[i], text_hash, escaped_hash, cues.start_frame[i], cues.end_frame[i],
+            cue_layer(batch.options, progress, i), obj });
+    }
+    // 差分更新を途中で中止した場合は、まだ処理していない前回のキューも残しておく (次回の更新で削除・再利用できるように)
+    const UpdatePlan& plan = progress.plan;
+    for (size_t j = 0; j < plan.consumed.size(); ++j) {
+        if (!plan.consumed[j]) layer.cues.push_back(plan.old[j]);
+    }
+    return layer;
+}
+
+static inline uint64_t mix_key(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+UpdateStats apply_update(ImportBatch& batch, ImportedLayer& previous, ImportProgress& progress, EDIT_SECTION* edit) {
+    using Clock = ImportMetrics::Clock;
+    using Kind = UpdatePlan::Kind;
+    ImportMetrics& m = batch.metrics;
+    const auto span_begin = Clock::now();
+    SrtCues& cues = batch.cues;
+    const ImportOptions& options = batch.options;
+    UpdatePlan& plan = progress.plan;
+    UpdateStats& st = progress.update;
+    const size_t n = cues.size();
+    const size_t next_before = progress.next;
+
+    if (plan.stage == UpdatePlan::Match) {
+        prepare_placement(cues, options, progress, m, edit);
+        plan.old = std::move(previous.cues);
+        previous.cues.clear();
+        auto& old = plan.old;
+        std::vector<uint64_t> text_hash(n);
+        plan.target.resize(n); // 置くレイヤー。上限に収まらないキューは対応付けず、前回のオブジェクトは削除される
+        for (size_t i = 0; i < n; ++i) {
+            text_hash[i] = srt_content_hash(cues.text(i));
+            plan.target[i] = cue_layer(options, progress, i);
+        }
+
+        // 新しいキューごとに対応する前回のキューを探す。
+        // 時刻と本文が同じもの → 時刻が同じもの (本文の変更) → 本文が同じもの (時刻の変更) の順に、残ったもの同士で対応付ける。
+        plan.match_of.assign(n, SIZE_MAX);
+        plan.kind.assign(n, Kind::None);
+        plan.used.assign(old.size(), false);
+        auto match_pass = [&](Kind k, auto key_old, auto key_new, auto same) {
+            std::unordered_multimap<uint64_t, size_t> index;
+            index.reserve(old.size());
+            for (size_t j = 0; j < old.size(); ++j) {
+                if (!plan.used[j]) index.emplace(key_old(old[j]), j);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (plan.kind[i] != Kind::None || plan.target[i] < 0) continue;
+                auto range = index.equal_range(key_new(i));
+                for (auto it = range.first; it != range.second; ++it) {
+                    const size_t j = it->second;
+                    if (plan.used[j] || !same(old[j], i)) continue;
+                    plan.used[j] = true;
+                    plan.match_of[i] = j;
+                    plan.kind[i] = k;
+                    break;
+                }
+            }
+        };
+        match_pass(Kind::Same,
+            [](const ImportedCue& c) { return mix_key(mix_key((uint64_t)c.start_ms, (uint64_t)c.end_ms), c.text_hash); },
+            [&](size_t i) { return mix_key(mix_key((uint64_t)cues.start_ms[i], (uint64_t)cues.end_ms[i]), text_hash[i]); },
+            [&](const ImportedCue& c, size_t i) { return c.start_ms == cues.start_ms[i] && c.end_ms == cues.end_ms[i] && c.text_hash == text_hash[i]; });
+        match_pass(Kind::TextChanged,
+            [](const ImportedCue& c) { return mix_key((uint64_t)c.start_ms, (uint64_t)c.end_ms); },
+            [&](size_t i) { return mix_key((uint64_t)cues.start_ms[i], (uint64_t)cues.end_ms[i]); },
+            [&](const ImportedCue& c, size_t i) { return c.start_ms == cues.start_ms[i] && c.end_ms == cues.end_ms[i]; });
+        match_pass(Kind::Retimed,
+            [](const ImportedCue& c) { return c.text_hash; },
+            [&](size_t i) { return text_hash[i]; },
+            [&](const ImportedCue& c, size_t i) { return c.text_hash == text_hash[i]; });
+
+        plan.consumed.assign(old.size(), false);
+        progress.objects.assign(n, nullptr);
+        st = {};
+        // 前回のキューの削除 + 対応のあるキューの確認 + 対応の無いキューの生成。移動・本文の設定は確認で決まった時点で足す。
+        plan.work_total = 0;
+        for (size_t j = 0; j < old.size(); ++j) plan.work_total += plan.used[j] ? 0 : 1;
+        for (size_t i = 0; i < n; ++i) plan.work_total += plan.kind[i] != Kind::None || plan.target[i] >= 0 ? 1 : 0;
+        plan.stage = UpdatePlan::DeleteOld;
+        plan.cursor = 0;
+    }
+    auto& old = plan.old;
+
+    // 前回のハンドルは、触る直前に同じ位置にまだあるかを確かめてから使う (手動で消された・動かされた場合に備える)
+    auto still_there = [&](const ImportedCue& c) {
+        const auto t0 = Clock::now();
+        const bool ok = edit->find_object(c.layer, c.start_frame) == c.object;
+        m.add(ImportMetrics::PhaseValidate, t0, Clock::now());
+        return ok;
+    };
+    // 削除・移動・本文の設定の前には、本文も前回設定したものかを確かめる。
+    // プロジェクトを開き直すなどしてハンドルが別のオブジェクトを指している場合に、それを壊さないため。
+    // 編集セクションの合間に手で編集されることもあるため、確認は操作と同じ編集セクションで行う。
+    auto still_ours = [&](const ImportedCue& c) {
+        if (!still_there(c)) return false;
+        const auto t0 = Clock::now();
+        const char* value = edit->get_object_item_value(c.object, L"テキスト", L"テキスト");
+        m.add(ImportMetrics::PhaseValidate, t0, Clock::now());
+        if (!value) {
+            ++m.api_failures[ImportMetrics::ApiGetItemValue];
+            return false;
+        }
+        const uint64_t h = srt_content_hash(value);
+        return h == c.text_hash || h == c.escaped_hash;
+    };
+    auto remove = [&](const ImportedCue& c) {
+        const auto t0 = Clock::now();
+        edit->delete_object(c.object);
+        m.add(ImportMetrics::PhaseDelete, t0, Clock::now());
+    };
+    // 前回のオブジェクトが使えなくなったキューは作り直す
+    auto recreate = [&](size_t i) {
+        plan.kind[i] = Kind::None;
+        ++plan.work_total;
+    };
+
+    // この編集セクションで行うホストAPIの操作の数 (確認・削除・移動・本文の設定・生成をそれぞれ1件と数える)
+    size_t budget = options.batch_size > 0 ? (size_t)options.batch_size : SIZE_MAX;
+    auto take = [&] {
+        if (budget == 0) return false;
+        --budget;
+        ++plan.work_done;
+        return true;
+    };
+
+    // 1) 対応の無い前回のキューを削除して場所を空ける
+    if (plan.stage == UpdatePlan::DeleteOld) {
+        for (; plan.cursor < old.size(); ++plan.cursor) {
+            const size_t j = plan.cursor;
+            if (plan.used[j]) continue;
+            if (!take()) break;
+            plan.consumed[j] = true;
+            if (!still_ours(old[j])) continue;
+            remove(old[j]);
+            ++st.deleted;
+        }
+        if (plan.cursor == old.size()) {
+            plan.stage = UpdatePlan::Check;
+            plan.cursor = 0;
+        }
+    }
+
+    // 2) 対応のあるキュー: まだ残っていて変化が無ければ何もしない。時刻 (フレーム) が変わったものは移動し、本文が変わったものは設定し直す
+    if (plan.stage == UpdatePlan::Check) {
+        for (; plan.cursor < n; ++plan.cursor) {
+            const size_t i = plan.cursor;
+            if (plan.kind[i] == Kind::None) continue;
+            if (!take()) break;
+            const size_t j = plan.match_of[i];
+            const ImportedCue& c = old[j];
+            const bool same_place = c.start_frame == cues.start_frame[i] && c.end_frame == cues.end_frame[i] && c.layer == plan.target[i];
+            // 本文が同じでフレームも変わらなければ (ミリ秒だけ変わった場合も) そのまま使う
+            if (same_place && plan.kind[i] != Kind::TextChanged) {
+                plan.consumed[j] = true;
+                if (!still_there(c)) {
+                    recreate(i); // 無くなっていれば作り直す
+                    continue;
+                }
+                progress.objects[i] = c.object;
+                ++st.kept;
+                continue;
+            }
+            (same_place ? plan.text_only : plan.retime).push_back(i);
+            ++plan.work_total;
+        }
+        if (plan.cursor == n) {
+            plan.stage = UpdatePlan::Move;
+            plan.cursor = 0;
+            plan.move_round = 0;
+        }
+    }
+
+    // 長さが同じなら move_object で動かす。移動先が別の移動待ちのオブジェクトで塞がっている場合があるため、失敗したものは一巡後に再試行する。
+    while (plan.stage == UpdatePlan::Move) {
+        for (; plan.cursor < plan.retime.size(); ++plan.cursor) {
+            if (!take()) break;
+            const size_t i = plan.retime[plan.cursor];
+            const size_t j = plan.match_of[i];
+            ImportedCue& c = old[j];
+            if (!still_ours(c)) {
+                plan.consumed[j] = true;
+                recreate(i);
+                continue;
+            }
+            const bool same_length = (c.end_frame - c.start_frame) == (cues.end_frame[i] - cues.start_frame[i]);
+            bool moved = false;
+            if (same_length) {
+                const auto t0 = Clock::now();
+                moved = edit->move_object(c.object, plan.target[i], cues.start_frame[i]);
+                m.add(ImportMetrics::PhaseMove, t0, Clock::now());
+                if (!moved) ++m.api_failures[ImportMetrics::ApiMoveObject];
+            }
+            if (moved) {
+                ++st.moved;
+                if (plan.kind[i] == Kind::TextChanged) {
+                    // 本文は後で設定する。それまでは移動先を前回の記録として扱う
+                    c.start_frame = cues.start_frame[i];
+                    c.end_frame = cues.end_frame[i];
+                    c.layer = plan.target[i];
+                    plan.text_only.push_back(i);
+                    ++plan.work_total;
+                } else {
+                    plan.consumed[j] = true;
+                    progress.objects[i] = c.object;
+                }
+            } else if (same_length && plan.move_round == 0) {
+                plan.pending.push_back(i);
+                ++plan.work_total;
+            } else {
+                // 長さが変わったもの (move_object では変えられない) と移動できなかったものは作り直す
+                plan.consumed[j] = true;
+                remove(c);
+                recreate(i);
+            }
+        }
+        if (plan.cursor < plan.retime.size()) break;
+        plan.retime.swap(plan.pending);
+        plan.pending.clear();
+        plan.cursor = 0;
+        if (plan.move_round++ > 0 || plan.retime.empty()) {
+            plan.retime.clear();
+            plan.stage = UpdatePlan::Retext;
+        }
+    }
+
+    if (plan.stage == UpdatePlan::Retext) {
+        for (; plan.cursor < plan.text_only.size(); ++plan.cursor) {
+            if (!take()) break;
+            const size_t i = plan.text_only[plan.cursor];
+            const size_t j = plan.match_of[i];
+            const ImportedCue& c = old[j];
+            plan.consumed[j] = true;
+            if (!still_ours(c)) {
+                recreate(i);
+                continue;
+            }
+            progress.objects[i] = c.object;
+            set_cue_text(cues.text(i), c.object, options, progress.newline, m, edit);
+            ++st.retexted;
+        }
+        if (plan.cursor == plan.text_only.size()) {
+            plan.stage = UpdatePlan::Create;
+            plan.cursor = 0;
+        }
+    }
+
+    // 3) 対応の無い新しいキュー (と作り直すもの) を生成する
+    if (plan.stage == UpdatePlan::Create) {
+        for (; plan.cursor < n; ++plan.cursor) {
+            const size_t i = plan.cursor;
+            if (plan.kind[i] != Kind::None || plan.target[i] < 0) continue;
+            if (!take()) break;
+            OBJECT_HANDLE obj = create_cue_object(cues, i, plan.target[i], batch.alias, m, edit);
+            if (!obj) continue;
+            progress.objects[i] = obj;
+            set_cue_text(cues.text(i), obj, options, progress.newline, m, edit);
+            if (plan.match_of[i] == SIZE_MAX) ++st.created;
+            else ++st.recreated;
+        }
+        if (plan.cursor == n) plan.stage = UpdatePlan::Done;
+    }
+
+    size_t present = 0;
+    for (OBJECT_HANDLE obj : progress.objects) present += obj ? 1 : 0;
+    progress.inserted = present;
+    ++m.edit_sections;
+    if (plan.done()) {
+        progress.next = n;
+        m.inserted += present;
+        previous = record_imported_layer(batch, progress);
+    } else {
+        // 進み具合は操作の数の割合をキュー数に換算する (反映し終えるまでは n に達しない)
+        progress.next = n ? std::min(n - 1, (size_t)((double)plan.work_done / (double)std::max<size_t>(plan.work_total, 1) * (double)n)) : 0;
+    }
+    m.spans.push_back({ "update", 1, m.since_origin_us(span_begin), m.since_origin_us(Clock::now()), next_before, progress.next });
+    return st;
+}
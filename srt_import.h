@@ -0,0 +1,173 @@
+#pragma once
+
+// タイムラインへの反映 (plugin2.h の EDIT_SECTION を使う部分)
+// UI には依存しないため、モックのホストを使ったヘッドレスのベンチマークからも呼べる。
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "win32_compat.h"
+#include "plugin2.h"
+#include "logger2.h"
+#include "srt_core.h"
+#include "srt_cache.h"
+#include "import_metrics.h"
+
+// 複数行本文の渡し方
+enum class NewlineMode {
+    Auto,    // 最初の複数行本文で実改行が通るか確認し、以降はその結果を使う
+    Raw,     // 常に実改行 (LF) で設定する
+    Escaped, // 常に \n にエスケープして設定する
+    Verify,  // 毎回、実改行で設定して読み戻し、反映されていなければ \n で再設定する (デバッグ用)
+};
+
+// 反映方法の設定 (見た目の設定は AliasStyle 側)
+struct ImportOptions {
+    int layer = 1;      // 1始まり
+    int batch_size = 0; // 1回の編集セクションで反映する件数 (0 以下は一括)。差分更新では削除・移動なども1件と数える
+    NewlineMode newline_mode = NewlineMode::Auto;
+    bool write_trace = false; // SRT の隣に計測結果のトレース (<SRT名>.trace.json) を書き出す
+    bool use_cache = true;    // パース結果をディスクにキャッシュし、同じ内容なら再利用する
+    std::filesystem::path cache_dir; // 空なら default_srt_cache_dir()
+    uint64_t cache_max_bytes = SrtParseCache::kDefaultMaxBytes;
+    bool update = false; // 同じレイヤーの前回のインポートがあれば、差分だけを反映する
+    // 時刻範囲 [window_begin_ms, window_end_ms) と重なるキューだけを読み込む
+    bool window = false;
+    int64_t window_begin_ms = 0;
+    int64_t window_end_ms = INT64_MAX; // INT64_MAX なら末尾まで
+    bool rebase = false; // window_begin_ms がフレーム0になるように時刻をずらす
+    // 重なるキューを layer から始まる最大 max_layers 個のレイヤーに振り分ける。
+    // 振り分けはホストAPIを呼ぶ前に済ませるため、重なりによる生成の失敗は起きない。収まらないキューは生成しない。
+    bool pack_layers = false;
+    int max_layers = 8;
+    CoalesceOptions coalesce; // フレーム確定後、反映前に連続キューを結合する (既定ではなにもしない)
+    // 時刻の変換。範囲の読み込み・rebase の後、フレームへの変換の前に、読み込んだ時刻全体へ適用する。
+    TimingTransform timing; // t * scale + offset_ms
+    // 2点同期: sync_cue[k] 番目 (0 始まり) のキューの開始を sync_ms[k] に合わせる。有効なら timing の代わりに使う。
+    // 番号は読み込んだキューの中で数える (時刻範囲を指定した場合は範囲内の先頭が 0)。
+    bool sync = false;
+    size_t sync_cue[2] = { 0, 0 };
+    int64_t sync_ms[2] = { 0, 0 };
+};
+
+// インポート中に判定した複数行本文の渡し方 (NewlineMode::Auto 用) と作業バッファ
+struct NewlineState {
+    enum Encoding { Unknown, Raw, Escaped };
+    Encoding resolved = Unknown;
+    std::string scratch;
+};
+
+// インポート1回分の準備済みデータ。編集セクション外 (ワーカースレッド) で作成する。
+struct ImportBatch {
+    std::filesystem::path path;
+    ImportOptions options;
+    AliasStyle style;
+    SrtCues cues;
+    AliasTemplate alias;
+    ImportMetrics metrics;
+};
+
+// 差分更新の結果 (キューの件数)
+struct UpdateStats {
+    size_t kept = 0;      // 変化なし (ホストAPIを呼ばない)
+    size_t retexted = 0;  // 本文だけ設定し直した
+    size_t moved = 0;     // move_object で時刻を変えた
+    size_t recreated = 0; // 長さが変わった・前回のオブジェクトが見つからない等で作り直した
+    size_t deleted = 0;   // 新しいSRTに無くなった
+    size_t created = 0;   // 新しく増えた
+};
+
+// 前回インポートしたキュー1件分 (差分更新用)
+struct ImportedCue {
+    int64_t start_ms;
+    int64_t end_ms;
+    uint64_t text_hash;
+    uint64_t escaped_hash; // \n にエスケープして設定した場合の本文のハッシュ (改行も \ も無ければ text_hash と同じ)
+    int start_frame; // 配置したフレーム
+    int end_frame;
+    int layer; // 配置したレイヤー (0始まり)
+    // プロジェクトを開いている間だけ有効 (プロジェクトが替わったら記録ごと破棄する)。
+    // 使う前に find_object で確かめ、削除・移動・本文の設定の前には本文も記録と同じかを確かめる。
+    OBJECT_HANDLE object;
+};
+
+// 差分更新の計画と進み具合。apply_update の最初の呼び出しで新旧のキューを対応付け、
+// 以降は 前回のキューの削除 → 対応の確認 → 移動 → 本文の設定 → 生成 の順に batch_size 件ずつ反映する。
+struct UpdatePlan {
+    enum Stage { Match, DeleteOld, Check, Move, Retext, Create, Done };
+    enum class Kind : uint8_t { None, Same, TextChanged, Retimed }; // 新旧のキューの対応付けの種類
+    Stage stage = Match;
+    size_t cursor = 0;  // stage 内の次の位置
+    int move_round = 0; // 移動先が塞がっていたものは一巡後にもう一度だけ試す
+    std::vector<ImportedCue> old;  // 前回の記録 (最初の呼び出しで previous から移す)
+    std::vector<bool> used;        // old[j] に対応する新しいキューがあるか
+    std::vector<bool> consumed;    // old[j] を処理し終えたか。中止した場合、残りは記録に戻す
+    std::vector<size_t> match_of;  // 新しいキューごとの old の位置 (対応が無ければ SIZE_MAX)
+    std::vector<Kind> kind;
+    std::vector<int> target;       // 置くレイヤー (0始まり、-1 は上限超過)
+    std::vector<size_t> retime, pending, text_only; // 移動・移動の再試行・本文の設定を待つ新しいキュー
+    size_t work_done = 0, work_total = 0; // 進み具合の表示用 (ホストAPIを呼ぶ操作の数)
+
+    bool started() const { return stage != Match; }
+    bool done() const { return stage == Done; }
+};
+
+// 反映の進み具合。インポート1回につき1つ。
+struct ImportProgress {
+    size_t next = 0;      // 次に反映するキューの位置
+    size_t inserted = 0;  // 生成できたオブジェクト数
+    bool frames_ready = false;
+    std::vector<int> layers; // pack_layers のときのキューごとのレイヤー (layer からの相対位置、-1 は上限超過)
+    size_t overflow = 0;     // レイヤーの上限に収まらず生成しなかったキュー数
+    CoalesceStats coalesce;  // 結合で減らしたキュー数
+    NewlineState newline;
+    std::vector<OBJECT_HANDLE> objects; // キューごとのオブジェクト (生成できなかったものは nullptr)
+    UpdateStats update;
+    UpdatePlan plan; // 差分更新のときだけ使う
+};
+
+// レイヤー1つ分の前回のインポート
+struct ImportedLayer {
+    std::vector<ImportedCue> cues;
+};
+
+// 警告などの出力先 (nullptr なら出力しない)
+void set_import_logger(LOG_HANDLE* logger);
+
+// ファイル読み込み・パース・本文の正規化・alias生成。編集セクションの外で呼ぶ。
+// use_cache なら内容が同じSRTのパース結果をキャッシュから読み込む。
+// options.window なら、キャッシュが無くてもシーク索引で範囲に関係するブロックだけをパースする。
+void prepare_import_batch(ImportBatch& batch);
+
+// batch の反映に使ったレイヤー数 (pack_layers なら割り当てた最大のレイヤー + 1、それ以外は 1)
+int used_layer_count(const ImportBatch& batch, const ImportProgress& progress);
+
+// cues[begin, end) を反映し、生成できたオブジェクト数を返す。生成したオブジェクトは progress.objects に記録する。
+// alias は build_alias で生成済みであること。
+// progress.newline はインポート全体で共有し、複数行本文の渡し方の判定結果を保持する。
+// 各API呼び出しの所要時間と失敗数は metrics に積算する。
+size_t apply_entries_to_timeline(const SrtCues& cues, size_t begin, size_t end, const ImportOptions& options, const AliasTemplate& alias, ImportProgress& progress, ImportMetrics& metrics, EDIT_SECTION* edit);
+
+// 編集セクション内で次の batch_size 件を反映し、progress を進める。
+// 初回はプロジェクトのレート/スケールでフレーム位置を確定し、options.coalesce に従ってキューを結合し、
+// pack_layers ならレイヤーも割り当てる。
+void apply_import_step(ImportBatch& batch, ImportProgress& progress, EDIT_SECTION* edit);
+
+// 複数ファイルの prepare_import_batch を workers 個のスレッドで並行して行う (0 ならCPU数)。
+// 失敗したファイルは cues が空になる。
+void prepare_import_batches(std::vector<std::unique_ptr<ImportBatch>>& batches, size_t workers = 0);
+
+// 反映し終えた (または中止した) インポートから、差分更新用の記録を作る。
+// 差分更新を中止した場合は、まだ処理していない前回のキューも含める。
+ImportedLayer record_imported_layer(const ImportBatch& batch, const ImportProgress& progress);
+
+// 編集セクション内で、previous と batch.cues の差分だけを反映する。
+// 変化の無いキューにはホストAPIを呼ばず、本文の変更は既存のオブジェクトに設定し、時刻の変更は移動で済ませる。
+// batch_size > 0 なら1回の呼び出しで行う操作 (確認・削除・移動・本文の設定・生成) を batch_size 件までにし、
+// progress.plan.done() になるまで編集セクションごとに呼び直す (progress.next は反映し終えると cues.size() になる)。
+// 反映し終えると previous は新しい状態に置き換わる。途中で中止した場合は record_imported_layer で記録し直す。
+UpdateStats apply_update(ImportBatch& batch, ImportedLayer& previous, ImportProgress& progress, EDIT_SECTION* edit);
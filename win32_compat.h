@@ -0,0 +1,46 @@
+#pragma once
+
+// plugin2.h / logger2.h を Windows 以外でもインクルードするための型定義。
+// Windows では <windows.h> をそのまま使う。それ以外ではSDKヘッダが参照する型だけを用意する
+// (ヘッドレスのベンチマーク用。実際のWin32 APIは提供しない)。
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdint>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef int32_t LONG;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+typedef wchar_t WCHAR;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef wchar_t* LPWSTR;
+typedef const wchar_t* LPCWSTR;
+typedef void* LPVOID;
+typedef void* HANDLE;
+typedef intptr_t LPARAM;
+typedef uintptr_t WPARAM;
+typedef intptr_t LRESULT;
+
+struct HWND__;
+typedef HWND__* HWND;
+struct HINSTANCE__;
+typedef HINSTANCE__* HINSTANCE;
+typedef HINSTANCE HMODULE;
+
+// 入出力プラグイン用の構造体はポインタとしてのみ参照される
+struct tagBITMAPINFOHEADER;
+typedef tagBITMAPINFOHEADER BITMAPINFOHEADER;
+struct tWAVEFORMATEX;
+typedef tWAVEFORMATEX WAVEFORMATEX;
+
+#ifndef EXTERN_C
+#define EXTERN_C extern "C"
+#endif
+#endif